@@ -0,0 +1,148 @@
+// bench_tls.cpp — time one bulk share-vector transfer over loopback TCP in three modes:
+//   plain : raw socket, same bulk framing as send_vec
+//   user  : user-space TLS (SSL_write/SSL_read), same TLS 1.2 AES-GCM suite as ktls.hpp
+//   ktls  : KtlsContext handshake, then the raw socket (kernel record layer)
+// kTLS needs the kernel 'tls' module (sudo modprobe tls); without it that mode reports why.
+#include "common.hpp"
+#include "ktls.hpp"
+#include <boost/asio.hpp>
+#include <openssl/ssl.h>
+#include <algorithm>
+#include <chrono>
+#include <endian.h>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using boost::asio::ip::tcp;
+
+static std::vector<uint32_t> make_payload(std::size_t words){
+    std::mt19937_64 rng(1);
+    std::vector<ringArithmetic> v = DuAtAllahServer::rand_vec(words, rng);
+    std::vector<uint32_t> be(words);
+    for(std::size_t i=0;i<words;++i) be[i] = htobe32(v[i].value);
+    return be;
+}
+
+// User-space TLS context with the same protocol/cipher pinning as KtlsContext, minus the offload.
+static std::shared_ptr<SSL_CTX> user_ctx(const std::string& cert, const std::string& key){
+    std::shared_ptr<SSL_CTX> c(SSL_CTX_new(TLS_method()), SSL_CTX_free);
+    if(!c) throw std::runtime_error("SSL_CTX_new");
+    SSL_CTX_set_min_proto_version(c.get(), TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(c.get(), TLS1_2_VERSION);
+    SSL_CTX_set_cipher_list(c.get(), "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                     "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384");
+    if(SSL_CTX_use_certificate_chain_file(c.get(), cert.c_str()) != 1 ||
+       SSL_CTX_use_PrivateKey_file(c.get(), key.c_str(), SSL_FILETYPE_PEM) != 1)
+        throw std::runtime_error("load cert/key");
+    return c;
+}
+
+// Returns elapsed ms for sending `payload` from a client socket to an accepted server socket.
+static double run(const std::string& mode, const std::vector<uint32_t>& payload,
+                  const KtlsContext& ktls, const std::shared_ptr<SSL_CTX>& uctx)
+{
+    boost::asio::io_context io;
+    tcp::acceptor acc(io, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+    const std::size_t bytes = payload.size() * 4;
+
+    std::exception_ptr err;
+    std::thread rx([&]{
+        try{
+            tcp::socket s(io);
+            acc.accept(s);
+            std::vector<char> buf(1 << 20);
+            std::size_t got = 0;
+            if(mode == "user"){
+                std::unique_ptr<SSL, decltype(&SSL_free)> ssl(SSL_new(uctx.get()), SSL_free);
+                SSL_set_fd(ssl.get(), s.native_handle());
+                if(SSL_accept(ssl.get()) != 1) throw std::runtime_error("user tls accept");
+                while(got < bytes){
+                    int n = SSL_read(ssl.get(), buf.data(), static_cast<int>(buf.size()));
+                    if(n <= 0) throw std::runtime_error("SSL_read");
+                    got += static_cast<std::size_t>(n);
+                }
+            }else{
+                if(mode == "ktls") ktls.server(s);
+                while(got < bytes) got += s.read_some(boost::asio::buffer(buf));
+            }
+        } catch(...){ err = std::current_exception(); }
+    });
+
+    tcp::socket s(io);
+    s.connect(acc.local_endpoint());
+    double ms = 0;
+    try{
+        if(mode == "user"){
+            std::unique_ptr<SSL, decltype(&SSL_free)> ssl(SSL_new(uctx.get()), SSL_free);
+            SSL_set_fd(ssl.get(), s.native_handle());
+            if(SSL_connect(ssl.get()) != 1) throw std::runtime_error("user tls connect");
+            auto t0 = std::chrono::steady_clock::now();
+            const char* p = reinterpret_cast<const char*>(payload.data());
+            for(std::size_t off = 0; off < bytes; ){
+                int n = SSL_write(ssl.get(), p + off, static_cast<int>(std::min<std::size_t>(bytes - off, 1u << 30)));
+                if(n <= 0) throw std::runtime_error("SSL_write");
+                off += static_cast<std::size_t>(n);
+            }
+            rx.join();
+            ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }else{
+            if(mode == "ktls") ktls.client(s);
+            auto t0 = std::chrono::steady_clock::now();
+            boost::asio::write(s, boost::asio::buffer(payload.data(), bytes));
+            rx.join();
+            ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+    } catch(...){
+        boost::system::error_code ec; s.close(ec); acc.close(ec);
+        if(rx.joinable()) rx.join();
+        throw;
+    }
+    if(err) std::rethrow_exception(err);
+    return ms;
+}
+
+int main(int argc, char** argv){
+    std::size_t mb = 64;
+    int reps = 3;
+    std::string cert, key, ca;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        auto need = [&](int k){ if(i+k>=argc) throw std::runtime_error("missing arg after "+a); };
+        if(a=="--mb"){ need(1); mb = std::stoull(argv[++i]); }
+        else if(a=="--reps"){ need(1); reps = std::stoi(argv[++i]); }
+        else if(a=="--tls-cert"){ need(1); cert = argv[++i]; }
+        else if(a=="--tls-key"){ need(1); key = argv[++i]; }
+        else if(a=="--tls-ca"){ need(1); ca = argv[++i]; }
+        else if(a=="--help"){
+            std::cout << "Usage: " << argv[0] << " --tls-cert PEM --tls-key PEM --tls-ca PEM [--mb N] [--reps R]\n";
+            return 0;
+        }
+    }
+    if(cert.empty() || key.empty() || ca.empty()){ std::cerr << "--tls-cert, --tls-key and --tls-ca required\n"; return 1; }
+
+    try{
+        KtlsContext ktls(cert, key, ca);
+        auto uctx = user_ctx(cert, key);
+        auto payload = make_payload(mb * (1u << 20) / 4);
+
+        for(const std::string mode : {"plain", "user", "ktls"}){
+            for(int r=0;r<reps;++r){
+                try{
+                    double ms = run(mode, payload, ktls, uctx);
+                    std::cout << mode << "\t" << mb << " MB\t" << ms << " ms\t" << (mb * 1000.0 / ms) << " MB/s\n";
+                } catch(const std::exception& e){
+                    std::cout << mode << "\tunavailable: " << e.what() << "\n";
+                    break;
+                }
+            }
+        }
+    } catch(const std::exception& e){
+        std::cerr << "[bench] " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -5,14 +5,16 @@ set -euo pipefail
 SERVER_SRC="duatallah_pairing_server.cpp"
 CLIENT_SRC="duoram_party_client_sync.cpp"
 COORD_SRC="coordinator_cli.cpp"
+BENCH_SRC="bench_tls.cpp"
 
 SERVER_BIN="share_server"
 CLIENT_BIN="party_client"
 COORD_BIN="coordinator_cli"
+BENCH_BIN="bench_tls"
 
 CXX="${CXX:-g++}"
 CXXFLAGS="-std=c++20 -O2 -Wall -Wextra -Wpedantic"
-LDFLAGS="-lboost_system -lpthread"
+LDFLAGS="-lboost_system -lpthread -lssl -lcrypto"
 
 # ---- Checks ----
 need() {
@@ -37,5 +39,8 @@ ${CXX} ${CXXFLAGS} "${CLIENT_SRC}" -o "${CLIENT_BIN}" ${LDFLAGS}
 echo "Compiling ${COORD_SRC} -> ${COORD_BIN}"
 ${CXX} ${CXXFLAGS} "${COORD_SRC}" -o "${COORD_BIN}" ${LDFLAGS}
 
+echo "Compiling ${BENCH_SRC} -> ${BENCH_BIN}"
+${CXX} ${CXXFLAGS} "${BENCH_SRC}" -o "${BENCH_BIN}" ${LDFLAGS}
+
 echo "Build complete:"
-ls -lh "${SERVER_BIN}" "${CLIENT_BIN}" "${COORD_BIN}"
+ls -lh "${SERVER_BIN}" "${CLIENT_BIN}" "${COORD_BIN}" "${BENCH_BIN}"
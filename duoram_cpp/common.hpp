@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 #include <random>
+#include <thread>
+#include <algorithm>
 
 // ======================= ringArithmetic (mod 2^31) =======================
 class ringArithmetic {
@@ -87,6 +89,25 @@ public:
     }
 };
 
+// ======================= row-parallel loops =======================
+// Split [0, n) into contiguous blocks across hardware threads; small ranges run inline.
+// fn(lo, hi) must only touch rows in [lo, hi).
+template <class F>
+inline void parallel_rows(std::size_t n, F&& fn){
+    constexpr std::size_t MIN_BLOCK = 1u << 16;
+    std::size_t workers = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    workers = std::min(workers, (n + MIN_BLOCK - 1) / MIN_BLOCK);
+    if(workers <= 1){ fn(std::size_t{0}, n); return; }
+    std::vector<std::thread> ts; ts.reserve(workers - 1);
+    const std::size_t block = (n + workers - 1) / workers;
+    for(std::size_t w=1; w<workers; ++w){
+        std::size_t lo = w*block, hi = std::min(n, lo + block);
+        if(lo < hi) ts.emplace_back([&fn, lo, hi]{ fn(lo, hi); });
+    }
+    fn(std::size_t{0}, std::min(n, block));
+    for(auto& t: ts) t.join();
+}
+
 // ======================= duoram (local share) =======================
 class duoram{
     std::vector<ringArithmetic> data;
@@ -110,7 +131,29 @@ public:
     // oblivious add of a vector share
     void obliviousWrite(const std::vector<ringArithmetic>& toWrite){
         if(toWrite.size()!=rows) throw std::runtime_error("obliviousWrite: size mismatch");
-        for(std::size_t i = 0 ; i < rows; i++) data[i] += toWrite[i];
+        parallel_rows(rows, [&](std::size_t lo, std::size_t hi){
+            for(std::size_t i = lo ; i < hi; i++) data[i] += toWrite[i];
+        });
+    }
+
+    // ---- local linear maps with public coefficients (shares stay shares) ----
+    // Plain 32-bit wraparound then mask == arithmetic mod 2^31, and keeps the loops vectorizable.
+
+    // this = k * this
+    void scale(ringArithmetic k){
+        const uint32_t kv = k.value;
+        parallel_rows(rows, [&](std::size_t lo, std::size_t hi){
+            for(std::size_t i = lo; i < hi; i++) data[i].value = (data[i].value * kv) & ringArithmetic::MASK;
+        });
+    }
+    // this = a * x + b * y   (x, y may alias this)
+    void combine(ringArithmetic a, const duoram& x, ringArithmetic b, const duoram& y){
+        if(x.rows!=rows || y.rows!=rows) throw std::runtime_error("combine: size mismatch");
+        const uint32_t av = a.value, bv = b.value;
+        parallel_rows(rows, [&](std::size_t lo, std::size_t hi){
+            for(std::size_t i = lo; i < hi; i++)
+                data[i].value = (av * x.data[i].value + bv * y.data[i].value) & ringArithmetic::MASK;
+        });
     }
 
     ringArithmetic& operator[](std::size_t idx) { return data[idx]; }
@@ -135,6 +178,12 @@ struct DuAtAllahClient{
     ringArithmetic Z;                 // c_i
 };
 
+// Element-wise multiplication triples: X = a_i, Y = b_i, Z = c_i (a vector),
+// with c0 + c1 = a ⊙ b, i.e. one Beaver triple per row.
+struct BeaverMulClient{
+    std::vector<ringArithmetic> X, Y, Z;
+};
+
 struct DuAtAllahServer{
     std::vector<ringArithmetic> a0, a1, b0, b1;
     size_t dim = 0;
@@ -190,4 +239,16 @@ struct DuAtAllahServer{
         p1.X = a1; p1.Y = b1; p1.Z = c1; // party B
         return {p0, p1};
     }
+
+    std::pair<BeaverMulClient, BeaverMulClient> getMulShares() const {
+        // c[k] = a[k] * b[k], randomly split into c0 + c1
+        std::random_device rd; std::mt19937_64 rng(rd());
+        std::vector<ringArithmetic> c0 = rand_vec(dim, rng), c1(dim);
+        for(std::size_t i=0;i<dim;++i) c1[i] = (a0[i] + a1[i]) * (b0[i] + b1[i]) - c0[i];
+
+        BeaverMulClient p0, p1;
+        p0.X = a0; p0.Y = b0; p0.Z = std::move(c0); // party A
+        p1.X = a1; p1.Y = b1; p1.Z = std::move(c1); // party B
+        return {p0, p1};
+    }
 };
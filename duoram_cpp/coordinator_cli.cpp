@@ -1,10 +1,21 @@
 // coordinator_cli.cpp  (async READs to avoid deadlocks)
 #include "common.hpp"
+#include "ktls.hpp"
 #include <boost/asio.hpp>
 #include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -58,15 +69,32 @@ static inline uint32_t from_be32(uint32_t x){
     return be32toh(x);
 #endif
 }
+static inline uint64_t to_be64(uint64_t x){
+#if defined(_WIN32)
+    return _byteswap_uint64(x);
+#elif defined(__APPLE__)
+    return OSSwapHostToBigInt64(x);
+#else
+    return htobe64(x);
+#endif
+}
 static void write_all(tcp::socket& s, const void* p, std::size_t n){ boost::asio::write(s, boost::asio::buffer(p, n)); }
 static void read_all (tcp::socket& s, void* p, std::size_t n){ boost::asio::read (s, boost::asio::buffer(p, n)); }
 static void write_u8  (tcp::socket& s, uint8_t v){ write_all(s, &v, 1); }
 static uint8_t read_u8(tcp::socket& s){ uint8_t v=0; read_all(s,&v,1); return v; }
 static void write_be32_u32(tcp::socket& s, uint32_t v){ v = to_be32(v); write_all(s, &v, 4); }
 static uint32_t read_be32_u32(tcp::socket& s){ uint32_t v=0; read_all(s, &v, 4); return from_be32(v); }
+static void write_be64_u64(tcp::socket& s, uint64_t v){ v = to_be64(v); write_all(s, &v, 8); }
+static void write_be32_vec(tcp::socket& s, const std::vector<ringArithmetic>& v){
+    std::vector<uint32_t> be(v.size());
+    for(std::size_t i=0;i<v.size();++i) be[i] = to_be32(static_cast<uint32_t>(v[i]));
+    write_all(s, be.data(), be.size()*4);
+}
+static KtlsContext g_tls; // disabled unless --tls-* given
 static tcp::socket connect_to(boost::asio::io_context& io, const std::string& host, const std::string& port){
     tcp::resolver res(io); auto eps = res.resolve(host, port);
-    tcp::socket sock(io); boost::asio::connect(sock, eps); return sock;
+    tcp::socket sock(io); boost::asio::connect(sock, eps);
+    g_tls.client(sock); return sock;
 }
 
 // ========= CLI parsing & protocol =========
@@ -77,50 +105,286 @@ static HostPort parse_hp(const std::string& s){
 }
 enum : uint8_t {
     OP_WRITE_VEC   = 0x40,
-    OP_READ_SECURE = 0x41
+    OP_READ_SECURE = 0x41,
+    OP_SCALE       = 0x42,
+    OP_ADD_PUBLIC  = 0x43,
+    OP_WRITE_TABLE = 0x44,
+    OP_READ_TABLE  = 0x45,
+    OP_COMBINE     = 0x46,
+    OP_DOT_TABLES  = 0x47,
+    OP_MUL_TABLES  = 0x48
 };
+// Signed decimal -> ring element (negative values wrap mod 2^31)
+static ringArithmetic parse_ring(const std::string& s){
+    return ringArithmetic(static_cast<uint32_t>(static_cast<uint64_t>(std::stoll(s)) & ringArithmetic::MASK));
+}
 
 // ========= Single-client helpers =========
-static void send_vector_to_client(const HostPort& hp, uint8_t op,
-                                  const std::vector<ringArithmetic>& vec)
+// Table 0 keeps the original op codes; other tables use the table-addressed ops.
+// Returns whether the party acknowledged the write with "OK".
+static bool write_vector_on(tcp::socket& sock, uint32_t table, const std::vector<ringArithmetic>& vec){
+    if(table != 0){
+        write_u8(sock, OP_WRITE_TABLE);
+        write_be32_u32(sock, table);
+    }
+    else write_u8(sock, OP_WRITE_VEC);
+    write_be32_u32(sock, static_cast<uint32_t>(vec.size()));
+    write_be32_vec(sock, vec);
+    char ok[2];
+    read_all(sock, ok, 2);
+    return ok[0]=='O' && ok[1]=='K';
+}
+
+// Writes v0 to c0 and v1 to c1. Both connections (and TLS handshakes) are
+// made before either vector is sent, so an unreachable party leaves both
+// shares untouched (reached == false) instead of applying half a write.
+struct WriteOutcome { bool reached = false, ok0 = false, ok1 = false; };
+static WriteOutcome write_both(const HostPort& c0, const HostPort& c1, uint32_t table,
+                               const std::vector<ringArithmetic>& v0, const std::vector<ringArithmetic>& v1)
 {
     boost::asio::io_context io;
-    auto sock = connect_to(io, hp.host, hp.port);
-    const uint32_t dim = static_cast<uint32_t>(vec.size());
+    auto k0 = std::async(std::launch::async, [&]{ return connect_to(io, c0.host, c0.port); });
+    auto k1 = std::async(std::launch::async, [&]{ return connect_to(io, c1.host, c1.port); });
+    std::optional<tcp::socket> s0, s1;
+    try{ s0.emplace(k0.get()); } catch(const std::exception& e){ std::cerr << "[coord] c0 unreachable: " << e.what() << "\n"; }
+    try{ s1.emplace(k1.get()); } catch(const std::exception& e){ std::cerr << "[coord] c1 unreachable: " << e.what() << "\n"; }
+    WriteOutcome r;
+    if(!s0 || !s1) return r;
 
-    write_u8(sock, op);
-    write_be32_u32(sock, dim);
-    for(uint32_t i=0;i<dim;++i) write_be32_u32(sock, static_cast<uint32_t>(vec[i]));
-
-    if(op == OP_WRITE_VEC){
-        char ok[2]; boost::system::error_code ec;
-        sock.read_some(boost::asio::buffer(ok,2), ec); // best-effort
-    }
+    r.reached = true;
+    auto w0 = std::async(std::launch::async, [&]{ return write_vector_on(*s0, table, v0); });
+    auto w1 = std::async(std::launch::async, [&]{ return write_vector_on(*s1, table, v1); });
+    try{ r.ok0 = w0.get(); } catch(const std::exception& e){ std::cerr << "[coord] table " << table << ": write to c0 failed: " << e.what() << "\n"; }
+    try{ r.ok1 = w1.get(); } catch(const std::exception& e){ std::cerr << "[coord] table " << table << ": write to c1 failed: " << e.what() << "\n"; }
+    return r;
 }
 
-static uint32_t send_vector_and_get_share(const HostPort& hp,
+static uint32_t send_vector_and_get_share(const HostPort& hp, uint32_t table,
                                           const std::vector<ringArithmetic>& vec)
 {
     boost::asio::io_context io;
     auto sock = connect_to(io, hp.host, hp.port);
     const uint32_t dim = static_cast<uint32_t>(vec.size());
 
-    write_u8(sock, OP_READ_SECURE);
+    if(table != 0){
+        write_u8(sock, OP_READ_TABLE);
+        write_be32_u32(sock, table);
+    }
+    else write_u8(sock, OP_READ_SECURE);
     write_be32_u32(sock, dim);
-    for(uint32_t i=0;i<dim;++i) write_be32_u32(sock, static_cast<uint32_t>(vec[i]));
+    write_be32_vec(sock, vec);
     uint32_t share = read_be32_u32(sock);
     return share;
 }
 
+static uint32_t dot_tables_share(const HostPort& hp, uint64_t opid, uint32_t x, uint32_t y){
+    boost::asio::io_context io;
+    auto sock = connect_to(io, hp.host, hp.port);
+    write_u8(sock, OP_DOT_TABLES);
+    write_be64_u64(sock, opid);
+    write_be32_u32(sock, x);
+    write_be32_u32(sock, y);
+    return read_be32_u32(sock);
+}
+
+// Linear transforms: the same request goes to both parties concurrently (they
+// epoch-sync with each other before applying), and each must answer "OK".
+static void send_transform(const HostPort& hp, const std::function<void(tcp::socket&)>& body){
+    boost::asio::io_context io;
+    auto sock = connect_to(io, hp.host, hp.port);
+    body(sock);
+    char ok[2];
+    read_all(sock, ok, 2);
+    if(ok[0]!='O' || ok[1]!='K') throw std::runtime_error("transform not acknowledged");
+}
+static void transform_both(const HostPort& c0, const HostPort& c1,
+                           const std::function<void(tcp::socket&)>& body){
+    auto f0 = std::async(std::launch::async, [&]{ send_transform(c0, body); });
+    auto f1 = std::async(std::launch::async, [&]{ send_transform(c1, body); });
+    f0.get(); f1.get();
+}
+static uint64_t make_opid(){
+    return (static_cast<uint64_t>(std::random_device{}()) << 32) ^ static_cast<uint64_t>(std::random_device{}());
+}
+static std::vector<ringArithmetic> load_public_vector(const std::string& path, std::size_t dim){
+    std::ifstream in(path);
+    if(!in) throw std::runtime_error("cannot open " + path);
+    std::vector<ringArithmetic> v; v.reserve(dim);
+    std::string tok;
+    while(in >> tok) v.push_back(parse_ring(tok));
+    if(v.size() != dim) throw std::runtime_error(path + ": expected " + std::to_string(dim) + " values");
+    return v;
+}
+
+// ========= Write-aggregating daemon =========
+// Writes are additive, so the k user writes that land in one window fold into a
+// single share vector per party (per table): one O(n) OP_WRITE_VEC instead of k.
+enum : uint8_t {
+    OP_USER_WRITE = 0x50 // user -> daemon: [op][table][idx][val] -> reply below
+};
+// Replies, decided per table of the batch:
+//   "OK" both parties applied the table's share vector
+//   "ER" neither did (e.g. a party was unreachable, which is checked before
+//        either share is sent); the shares are unchanged and the write may be retried
+//   "IC" one party applied it and the other failed mid-write: the table's
+//        shares no longer reconstruct, so the daemon stops serving.
+
+struct PendingWrite {
+    uint32_t table = 0, idx = 0;
+    ringArithmetic val;
+    std::shared_ptr<tcp::socket> sock; // acked after the batch is written
+};
+
+class WriteBatcher {
+public:
+    void push(PendingWrite w){
+        { std::lock_guard<std::mutex> lk(mu_); q_.push_back(std::move(w)); }
+        cv_.notify_one();
+    }
+    // Blocks for the first write, then collects until the window closes or max_batch is reached.
+    std::vector<PendingWrite> next_batch(std::chrono::milliseconds window, std::size_t max_batch){
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&]{ return !q_.empty(); });
+        cv_.wait_until(lk, std::chrono::steady_clock::now() + window, [&]{ return q_.size() >= max_batch; });
+        const std::size_t n = std::min(max_batch, q_.size());
+        std::vector<PendingWrite> out(std::make_move_iterator(q_.begin()), std::make_move_iterator(q_.begin() + n));
+        q_.erase(q_.begin(), q_.begin() + n);
+        return out;
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<PendingWrite> q_;
+};
+
+// Returns false if some table was left with inconsistent shares.
+static bool flush_batch(std::vector<PendingWrite>& batch, std::size_t dim,
+                        const HostPort& c0, const HostPort& c1)
+{
+    std::map<uint32_t, std::vector<ringArithmetic>> sums;
+    for(const auto& w: batch){
+        auto& v = sums[w.table];
+        if(v.empty()) v.assign(dim, ringArithmetic(0));
+        v[w.idx] += w.val;
+    }
+
+    std::map<uint32_t, const char*> reply;
+    bool consistent = true;
+    for(auto& [table, e]: sums){
+        std::vector<ringArithmetic> f = make_random_vector(dim);
+        for(std::size_t i=0;i<dim;i++) e[i] -= f[i];
+        const WriteOutcome r = write_both(c0, c1, table, e, f);
+        if(r.ok0 && r.ok1) reply[table] = "OK";
+        else if(!r.ok0 && !r.ok1) reply[table] = "ER";
+        else{
+            reply[table] = "IC";
+            consistent = false;
+            std::cerr << "[coord] FATAL: table " << table << " shares are INCONSISTENT ("
+                      << (r.ok0 ? "c0" : "c1") << " applied the batch, " << (r.ok0 ? "c1" : "c0")
+                      << " did not); reconstruction of this table is now wrong\n";
+        }
+    }
+
+    std::size_t applied = 0;
+    for(auto& w: batch){
+        const char* r = reply.at(w.table);
+        applied += (r[0] == 'O');
+        boost::system::error_code ec;
+        boost::asio::write(*w.sock, boost::asio::buffer(r, 2), ec);
+    }
+    std::cout << "[coord] batch of " << batch.size() << " write(s) over " << sums.size()
+              << " table(s): " << applied << " applied, " << (batch.size() - applied) << " rejected\n";
+    return consistent;
+}
+
+static int serve(const HostPort& listen, std::size_t dim, std::chrono::milliseconds window,
+                 std::size_t max_batch, const HostPort& c0, const HostPort& c1)
+{
+    boost::asio::io_context io;
+    tcp::resolver res(io);
+    tcp::endpoint ep = *res.resolve(listen.host, listen.port).begin();
+    tcp::acceptor acc(io);
+    acc.open(ep.protocol());
+    acc.set_option(boost::asio::socket_base::reuse_address(true));
+    acc.bind(ep);
+    acc.listen();
+    std::cout << "[coord] daemon @" << listen.host << ":" << listen.port << " | dim=" << dim
+              << " | window=" << window.count() << "ms | max-batch="
+              << (max_batch == SIZE_MAX ? std::string("unlimited") : std::to_string(max_batch)) << "\n";
+
+    // Both detached threads own what they use: the batcher is shared, the rest is copied.
+    auto batcher = std::make_shared<WriteBatcher>();
+    std::thread([batcher, window, max_batch, dim, c0, c1]{
+        for(;;){
+            auto batch = batcher->next_batch(window, max_batch);
+            if(!flush_batch(batch, dim, c0, c1)){
+                // Serving more writes on top of unreconstructable shares would only hide the damage.
+                std::cerr << "[coord] FATAL: stopping the daemon; restore both parties before restarting" << std::endl;
+                std::cout.flush();
+                std::quick_exit(3);
+            }
+        }
+    }).detach();
+
+    for(;;){
+        auto sock = std::make_shared<tcp::socket>(io);
+        acc.accept(*sock);
+        std::thread([batcher, sock, dim]{
+            try{
+                g_tls.server(*sock);
+                if(read_u8(*sock) != OP_USER_WRITE) throw std::runtime_error("bad op (expected OP_USER_WRITE)");
+                PendingWrite w;
+                w.table = read_be32_u32(*sock);
+                w.idx   = read_be32_u32(*sock);
+                w.val   = ringArithmetic(read_be32_u32(*sock));
+                if(w.idx >= dim) throw std::runtime_error("idx out of range");
+                w.sock = sock;
+                batcher->push(std::move(w));
+            } catch(const std::exception& e){
+                std::cerr << "[coord] request error: " << e.what() << "\n";
+                boost::system::error_code ec;
+                boost::asio::write(*sock, boost::asio::buffer("ER", 2), ec);
+            }
+        }).detach();
+    }
+}
+
+// user side of the daemon
+// Returns the daemon's two-byte reply ("OK", "ER" or "IC").
+static std::string submit_write(const HostPort& daemon, uint32_t table, uint32_t idx, ringArithmetic val){
+    boost::asio::io_context io;
+    auto sock = connect_to(io, daemon.host, daemon.port);
+    write_u8(sock, OP_USER_WRITE);
+    write_be32_u32(sock, table);
+    write_be32_u32(sock, idx);
+    write_be32_u32(sock, static_cast<uint32_t>(val));
+    char reply[2];
+    read_all(sock, reply, 2);
+    return std::string(reply, 2);
+}
+
 // ========= Usage =========
 static void usage(const char* prog){
     std::cerr <<
     "Usage:\n"
     "  " << prog << " --op read  --dim N --idx I --c0 H:P --c1 H:P\n"
     "  " << prog << " --op write --dim N --idx I --val V --c0 H:P --c1 H:P\n"
+    "  " << prog << " --op scale   --table T --k K --c0 H:P --c1 H:P              (T := K*T)\n"
+    "  " << prog << " --op addpub  --table T --dim N --vec FILE --c0 H:P --c1 H:P (T := T + public vector)\n"
+    "  " << prog << " --op combine --table D --src X --src2 Y --a A --b B --c0 H:P --c1 H:P\n"
+    "                                                                         (D := A*X + B*Y)\n"
+    "  " << prog << " --op dot     --src X --src2 Y --c0 H:P --c1 H:P              (<X, Y>)\n"
+    "  " << prog << " --op mul     --table D --src X --src2 Y --c0 H:P --c1 H:P    (D := X ⊙ Y, per row)\n"
+    "  " << prog << " --op serve   --listen H:P --dim N [--window-ms W] [--max-batch M] --c0 H:P --c1 H:P\n"
+    "                                                   (daemon: batch user writes per window)\n"
+    "  " << prog << " --op submit  --daemon H:P --idx I --val V [--table T]      (write through the daemon)\n"
+    "  read/write take [--table T] (default 0)\n"
+    "  (either form) [--tls-cert PEM --tls-key PEM --tls-ca PEM]  mutual TLS, offloaded to the kernel\n"
     "Notes:\n"
     "  - READ runs both requests concurrently to avoid deadlocks.\n"
-    "  - WRITE sends share vectors to both clients.\n";
+    "  - WRITE sends share vectors to both clients.\n"
+    "  - scale/addpub/combine run locally on each party's shares in one pass; constants may be negative.\n";
 }
 
 // ========= Main =========
@@ -128,7 +392,13 @@ int main(int argc, char** argv){
     std::string op;
     std::size_t dim = 0, idx = 0;
     uint64_t val = 0;
+    uint32_t table = 0, src = 0, src2 = 0;
+    std::string k_s = "1", a_s = "1", b_s = "1", vec_path;
     std::string c0_s, c1_s;
+    std::string listen_s, daemon_s;
+    uint64_t window_ms = 5;
+    std::size_t max_batch = 0;
+    std::string tls_cert, tls_key, tls_ca;
 
     for(int i=1;i<argc;++i){
         std::string a = argv[i];
@@ -137,29 +407,66 @@ int main(int argc, char** argv){
         else if(a=="--dim"){ need(1); dim = std::stoull(argv[++i]); }
         else if(a=="--idx"){ need(1); idx = std::stoull(argv[++i]); }
         else if(a=="--val"){ need(1); val = std::stoull(argv[++i]); }
+        else if(a=="--table"){ need(1); table = static_cast<uint32_t>(std::stoul(argv[++i])); }
+        else if(a=="--src"){ need(1); src = static_cast<uint32_t>(std::stoul(argv[++i])); }
+        else if(a=="--src2"){ need(1); src2 = static_cast<uint32_t>(std::stoul(argv[++i])); }
+        else if(a=="--k"){ need(1); k_s = argv[++i]; }
+        else if(a=="--a"){ need(1); a_s = argv[++i]; }
+        else if(a=="--b"){ need(1); b_s = argv[++i]; }
+        else if(a=="--vec"){ need(1); vec_path = argv[++i]; }
+        else if(a=="--listen"){ need(1); listen_s = argv[++i]; }
+        else if(a=="--daemon"){ need(1); daemon_s = argv[++i]; }
+        else if(a=="--window-ms"){ need(1); window_ms = std::stoull(argv[++i]); }
+        else if(a=="--max-batch"){ need(1); max_batch = std::stoull(argv[++i]); }
         else if(a=="--c0"){ need(1); c0_s = argv[++i]; }
         else if(a=="--c1"){ need(1); c1_s = argv[++i]; }
+        else if(a=="--tls-cert"){ need(1); tls_cert = argv[++i]; }
+        else if(a=="--tls-key"){ need(1); tls_key = argv[++i]; }
+        else if(a=="--tls-ca"){ need(1); tls_ca = argv[++i]; }
         else if(a=="--help"){ usage(argv[0]); return 0; }
         else { std::cerr << "Unknown arg: " << a << "\n"; usage(argv[0]); return 1; }
     }
 
-    if(op.empty() || dim==0 || c0_s.empty() || c1_s.empty()){
+    const bool needs_dim = (op=="read" || op=="write" || op=="addpub" || op=="serve");
+    if(op=="submit"){
+        if(daemon_s.empty()){ usage(argv[0]); return 1; }
+    }
+    else if(op.empty() || (needs_dim && dim==0) || c0_s.empty() || c1_s.empty() || (op=="serve" && listen_s.empty())){
         usage(argv[0]); return 1;
     }
-    if(idx >= dim){
+    if((op=="read" || op=="write") && idx >= dim){
         std::cerr << "Index out of range (idx < dim required)\n"; return 1;
     }
 
-    HostPort c0 = parse_hp(c0_s);
-    HostPort c1 = parse_hp(c1_s);
-
     try{
+        if(!tls_cert.empty() || !tls_key.empty() || !tls_ca.empty()){
+            if(tls_cert.empty() || tls_key.empty() || tls_ca.empty())
+                throw std::runtime_error("--tls-cert, --tls-key and --tls-ca must be given together");
+            g_tls = KtlsContext(tls_cert, tls_key, tls_ca);
+        }
+
+        if(op == "submit"){
+            uint32_t vv = static_cast<uint32_t>(val & ringArithmetic::MASK);
+            std::string r = submit_write(parse_hp(daemon_s), table, static_cast<uint32_t>(idx), ringArithmetic(vv));
+            if(r == "OK"){ std::cout << "SUBMIT idx=" << idx << " value=" << vv << " acknowledged\n"; return 0; }
+            if(r == "IC"){ std::cout << "SUBMIT idx=" << idx << " value=" << vv << " FAILED: table shares inconsistent\n"; return 3; }
+            std::cout << "SUBMIT idx=" << idx << " value=" << vv << " REJECTED\n";
+            return 2;
+        }
+
+        HostPort c0 = parse_hp(c0_s);
+        HostPort c1 = parse_hp(c1_s);
+
+        if(op == "serve"){
+            return serve(parse_hp(listen_s), dim, std::chrono::milliseconds(window_ms),
+                         max_batch == 0 ? SIZE_MAX : max_batch, c0, c1);
+        }
         if(op == "read"){
             // Basis e_idx split into two additive shares
             auto [share0_vec, share1_vec] = makeStandardBasis(dim, idx, ringArithmetic(1));
 
-            auto fut0 = std::async(std::launch::async, [&]{ return send_vector_and_get_share(c0, share0_vec); });
-            auto fut1 = std::async(std::launch::async, [&]{ return send_vector_and_get_share(c1, share1_vec); });
+            auto fut0 = std::async(std::launch::async, [&]{ return send_vector_and_get_share(c0, table, share0_vec); });
+            auto fut1 = std::async(std::launch::async, [&]{ return send_vector_and_get_share(c1, table, share1_vec); });
 
             uint32_t s0 = fut0.get();
             uint32_t s1 = fut1.get();
@@ -170,14 +477,69 @@ int main(int argc, char** argv){
             uint32_t vv = static_cast<uint32_t>(val & ringArithmetic::MASK);
             auto [share0_vec, share1_vec] = makeStandardBasis(dim, idx, ringArithmetic(vv));
 
-            auto f0 = std::async(std::launch::async, [&]{ send_vector_to_client(c0, OP_WRITE_VEC, share0_vec); });
-            auto f1 = std::async(std::launch::async, [&]{ send_vector_to_client(c1, OP_WRITE_VEC, share1_vec); });
-            f0.get(); f1.get();
-
-            std::cout << "WRITE idx=" << idx << " value=" << vv << " (mod 2^31) sent as shares\n";
+            const WriteOutcome r = write_both(c0, c1, table, share0_vec, share1_vec);
+            if(r.ok0 && r.ok1){
+                std::cout << "WRITE idx=" << idx << " value=" << vv << " (mod 2^31) sent as shares\n";
+            }
+            else if(r.ok0 || r.ok1){
+                std::cerr << "WRITE idx=" << idx << " INCONSISTENT: only " << (r.ok0 ? "c0" : "c1")
+                          << " applied its share; table " << table << " no longer reconstructs\n";
+                return 3;
+            }
+            else{
+                std::cerr << "WRITE idx=" << idx << " failed: " << (r.reached ? "no party acknowledged" : "a party is unreachable")
+                          << "; nothing applied\n";
+                return 2;
+            }
+        }
+        else if(op == "scale"){
+            const ringArithmetic k = parse_ring(k_s);
+            const uint64_t opid = make_opid();
+            transform_both(c0, c1, [&](tcp::socket& s){
+                write_u8(s, OP_SCALE); write_be64_u64(s, opid);
+                write_be32_u32(s, table); write_be32_u32(s, static_cast<uint32_t>(k));
+            });
+            std::cout << "SCALE table=" << table << " by " << k << " (mod 2^31) applied\n";
+        }
+        else if(op == "addpub"){
+            const auto pub = load_public_vector(vec_path, dim);
+            const uint64_t opid = make_opid();
+            transform_both(c0, c1, [&](tcp::socket& s){
+                write_u8(s, OP_ADD_PUBLIC); write_be64_u64(s, opid);
+                write_be32_u32(s, table); write_be32_u32(s, static_cast<uint32_t>(dim));
+                write_be32_vec(s, pub);
+            });
+            std::cout << "ADDPUB table=" << table << " += " << vec_path << " applied\n";
+        }
+        else if(op == "combine"){
+            const ringArithmetic ca = parse_ring(a_s), cb = parse_ring(b_s);
+            const uint64_t opid = make_opid();
+            transform_both(c0, c1, [&](tcp::socket& s){
+                write_u8(s, OP_COMBINE); write_be64_u64(s, opid);
+                write_be32_u32(s, table); write_be32_u32(s, src); write_be32_u32(s, src2);
+                write_be32_u32(s, static_cast<uint32_t>(ca)); write_be32_u32(s, static_cast<uint32_t>(cb));
+            });
+            std::cout << "COMBINE table=" << table << " := " << ca << "*t" << src << " + " << cb << "*t" << src2 << " applied\n";
+        }
+        else if(op == "dot"){
+            const uint64_t opid = make_opid();
+            auto fut0 = std::async(std::launch::async, [&]{ return dot_tables_share(c0, opid, src, src2); });
+            auto fut1 = std::async(std::launch::async, [&]{ return dot_tables_share(c1, opid, src, src2); });
+            uint32_t s0 = fut0.get();
+            uint32_t s1 = fut1.get();
+            uint32_t sum = static_cast<uint32_t>((static_cast<uint64_t>(s0) + s1) & ringArithmetic::MASK);
+            std::cout << "DOT <t" << src << ", t" << src2 << "> -> reconstructed value = " << sum << "\n";
+        }
+        else if(op == "mul"){
+            const uint64_t opid = make_opid();
+            transform_both(c0, c1, [&](tcp::socket& s){
+                write_u8(s, OP_MUL_TABLES); write_be64_u64(s, opid);
+                write_be32_u32(s, table); write_be32_u32(s, src); write_be32_u32(s, src2);
+            });
+            std::cout << "MUL table=" << table << " := t" << src << " * t" << src2 << " (element-wise) stored\n";
         }
         else {
-            std::cerr << "Unknown --op (use 'read' or 'write')\n";
+            std::cerr << "Unknown --op (use read, write, scale, addpub, combine, dot, mul, serve or submit)\n";
             return 1;
         }
 
@@ -1,9 +1,13 @@
 // duatallah_pairing_server.cpp
 #include "common.hpp"  // ringArithmetic, DuAtAllahClient, DuAtAllahServer
+#include "ktls.hpp"    // KtlsContext
+#include "striping.hpp" // plan_stripes, for_each_stripe
 #include <boost/asio.hpp>
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -74,63 +78,166 @@ static uint8_t read_u8(tcp::socket& s){ uint8_t v=0; read_all(s, &v, 1); return
 static void write_u8(tcp::socket& s, uint8_t v){ write_all(s, &v, 1); }
 static uint32_t read_be32_u32(tcp::socket& s){ uint32_t be=0; read_all(s, &be, 4); return from_be32(be); }
 static void write_be32_u32(tcp::socket& s, uint32_t v){ v = to_be32(v); write_all(s, &v, 4); }
+static void write_be32_range(tcp::socket& s, const ringArithmetic* p, std::size_t n){
+    std::vector<uint32_t> be(n);
+    for(std::size_t i=0;i<n;++i) be[i] = to_be32(static_cast<uint32_t>(p[i]));
+    write_all(s, be.data(), be.size()*4);
+}
+static void write_be32_vec(tcp::socket& s, const std::vector<ringArithmetic>& v){ write_be32_range(s, v.data(), v.size()); }
 
 // -------- Protocol ops --------
 enum : uint8_t {
-    OP_REQUEST  = 0x31, // client -> server: [op][dim]
-    OP_RESPONSE = 0x33  // server -> client: [op][dim][X(dim)][Y(dim)][Z]
+    OP_REQUEST             = 0x31, // client -> server: [op][dim]
+    OP_RESPONSE            = 0x33, // server -> client: [op][dim][sid][X(dim)][Y(dim)][Z]
+    OP_REQUEST_STRIPED     = 0x34, // client -> server, one per stripe: [op][dim][nonce][k][n]
+                                   //   reply: [OP_RESPONSE][dim][sid][off][cnt][words of X||Y||Z]
+    OP_REQUEST_MUL         = 0x35, // element-wise triples: reply [OP_RESPONSE][dim][sid][X(dim)][Y(dim)][Z(dim)]
+    OP_REQUEST_MUL_STRIPED = 0x36  // as OP_REQUEST_STRIPED, frame X||Y||Z with Z(dim)
 };
 
-// -------- Waiting room (pair by dimension) --------
+// Correlation kinds; requests only pair with the same kind and dim.
+enum class TripleKind : uint8_t { Dot, Mul };
+static uint32_t frame_words(TripleKind kind, uint32_t dim){
+    return kind == TripleKind::Dot ? 2*dim + 1 : 3*dim;
+}
+
+// One party's request: a single socket, or n stripe sockets in stripe order.
+struct Link {
+    std::vector<std::shared_ptr<tcp::socket>> socks;
+    bool striped = false;
+};
+
+// -------- Stripe assembly (group n connections by client nonce) --------
+class StripeGroups {
+public:
+    // A group whose stripes have not all arrived by then is dropped.
+    static constexpr std::chrono::seconds TTL{10};
+
+    // Returns the complete link once all n stripes arrived; else an empty link.
+    // Dropping a group releases the sockets it holds, which closes them.
+    Link add(uint64_t nonce, uint8_t k, uint8_t n, std::shared_ptr<tcp::socket> s) {
+        std::lock_guard<std::mutex> lk(mu_);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = pending_.begin(); it != pending_.end(); )
+            it = (it->second.deadline <= now) ? pending_.erase(it) : std::next(it);
+
+        auto& g = pending_[nonce];
+        if (g.socks.empty()) { g.socks.resize(n); g.deadline = now + TTL; }
+        if (g.socks.size() != n || k >= n || g.socks[k]) {
+            pending_.erase(nonce);
+            throw std::runtime_error("bad stripe (k/n)");
+        }
+        g.socks[k] = std::move(s);
+        for (auto& x : g.socks) if (!x) return {};
+        Link link{std::move(g.socks), true};
+        pending_.erase(nonce);
+        return link;
+    }
+
+private:
+    struct Group {
+        std::vector<std::shared_ptr<tcp::socket>> socks;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    std::mutex mu_;
+    std::map<uint64_t, Group> pending_;
+};
+
+// -------- Waiting room (pair by kind and dimension) --------
 class PairingRoom {
 public:
-    // Returns (peer_socket, dim) if a match is ready; else (nullptr, 0) and queues this socket.
-    std::pair<std::shared_ptr<tcp::socket>, uint32_t>
-    add_and_try_pair(std::shared_ptr<tcp::socket> s, uint32_t dim) {
+    // Returns (peer_link, dim) if a match is ready; else (empty link, 0) and queues this link.
+    std::pair<Link, uint32_t>
+    add_and_try_pair(Link l, TripleKind kind, uint32_t dim) {
         std::lock_guard<std::mutex> lk(mu_);
-        auto& dq = waiting_[dim];
+        const auto key = std::make_pair(kind, dim);
+        auto& dq = waiting_[key];
         if (!dq.empty()) {
             auto peer = dq.front();
             dq.pop_front();
-            if (dq.empty()) waiting_.erase(dim);
+            if (dq.empty()) waiting_.erase(key);
             return {peer, dim};
         } else {
-            dq.push_back(std::move(s));
-            return {nullptr, 0};
+            dq.push_back(std::move(l));
+            return {Link{}, 0};
         }
     }
 
 private:
     std::mutex mu_;
-    std::map<uint32_t, std::deque<std::shared_ptr<tcp::socket>>> waiting_;
+    std::map<std::pair<TripleKind, uint32_t>, std::deque<Link>> waiting_;
 };
 
-// -------- Serialization of DuAtAllahClient (X=a_i, Y=b_i, Z=c_i) --------
-// server -> client: [OP_RESPONSE][dim:be32][sid:be64][X...][Y...][Z]
-static void send_client_share(tcp::socket& s, uint32_t dim, uint64_t sid, const DuAtAllahClient& c){
-    write_u8(s, OP_RESPONSE);
-    write_be32_u32(s, dim);
-    write_be64_u64(s, sid); // <= here
-    for(uint32_t i=0;i<dim;++i) write_be32_u32(s, static_cast<uint32_t>(c.X[i]));
-    for(uint32_t i=0;i<dim;++i) write_be32_u32(s, static_cast<uint32_t>(c.Y[i]));
-    write_be32_u32(s, static_cast<uint32_t>(c.Z));
+// -------- Serialization of client shares as one frame X||Y||Z --------
+static std::vector<ringArithmetic> to_frame(const DuAtAllahClient& c){
+    std::vector<ringArithmetic> frame; frame.reserve(c.X.size() + c.Y.size() + 1);
+    frame.insert(frame.end(), c.X.begin(), c.X.end());
+    frame.insert(frame.end(), c.Y.begin(), c.Y.end());
+    frame.push_back(c.Z);
+    return frame;
+}
+static std::vector<ringArithmetic> to_frame(const BeaverMulClient& c){
+    std::vector<ringArithmetic> frame; frame.reserve(c.X.size() + c.Y.size() + c.Z.size());
+    frame.insert(frame.end(), c.X.begin(), c.X.end());
+    frame.insert(frame.end(), c.Y.begin(), c.Y.end());
+    frame.insert(frame.end(), c.Z.begin(), c.Z.end());
+    return frame;
 }
 
+// server -> client: [OP_RESPONSE][dim:be32][sid:be64][frame...]
+// Striped: each stripe socket gets [OP_RESPONSE][dim][sid][off][cnt][its slice], in parallel.
+static void send_client_share(const Link& l, uint32_t dim, uint64_t sid,
+                              const std::vector<ringArithmetic>& frame){
+    if (!l.striped) {
+        tcp::socket& s = *l.socks[0];
+        write_u8(s, OP_RESPONSE);
+        write_be32_u32(s, dim);
+        write_be64_u64(s, sid);
+        write_be32_vec(s, frame);
+        return;
+    }
 
+    auto stripes = plan_stripes(static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(l.socks.size()));
+    for_each_stripe(stripes, [&](std::size_t k, const Stripe& st){
+        tcp::socket& s = *l.socks[k];
+        write_u8(s, OP_RESPONSE);
+        write_be32_u32(s, dim);
+        write_be64_u64(s, sid);
+        write_be32_u32(s, st.off);
+        write_be32_u32(s, st.cnt);
+        write_be32_range(s, frame.data() + st.off, st.cnt);
+    });
+}
 
 // -------- Per-connection handler --------
-static void handle_one(PairingRoom& room, std::shared_ptr<tcp::socket> sock) {
+static void handle_one(PairingRoom& room, StripeGroups& groups, const KtlsContext& tls,
+                       std::shared_ptr<tcp::socket> sock) {
     try {
+        tls.server(*sock);
         const uint8_t op  = read_u8(*sock);
-        if (op != OP_REQUEST) throw std::runtime_error("bad op (expected OP_REQUEST)");
+        if (op != OP_REQUEST && op != OP_REQUEST_STRIPED && op != OP_REQUEST_MUL && op != OP_REQUEST_MUL_STRIPED)
+            throw std::runtime_error("bad op (expected OP_REQUEST)");
+        const TripleKind kind = (op == OP_REQUEST_MUL || op == OP_REQUEST_MUL_STRIPED) ? TripleKind::Mul : TripleKind::Dot;
+        const bool striped = (op == OP_REQUEST_STRIPED || op == OP_REQUEST_MUL_STRIPED);
         const uint32_t dim = read_be32_u32(*sock);
         if (dim == 0) throw std::runtime_error("dim must be > 0");
 
-        std::cout << "[server] client requesting dim " << dim << "\n";
+        Link me{{sock}, false};
+        if (striped) {
+            const uint64_t nonce = read_be64_u64(*sock);
+            const uint8_t  k = read_u8(*sock);
+            const uint8_t  n = read_u8(*sock);
+            if (n == 0 || n > STRIPE_MAX || n > frame_words(kind, dim)) throw std::runtime_error("bad stripe count");
+            me = groups.add(nonce, k, n, sock);
+            if (me.socks.empty()) return; // other stripes of this request still arriving
+        }
+
+        std::cout << "[server] client requesting " << (kind == TripleKind::Mul ? "mul" : "dot") << " dim " << dim
+                  << (me.striped ? " (" + std::to_string(me.socks.size()) + " stripes)" : "") << "\n";
 
-        // Try to pair this socket. If no peer yet, just park it and return — DO NOT READ.
-        auto [peer, pdim] = room.add_and_try_pair(sock, dim);
-        if (!peer) {
+        // Try to pair this request. If no peer yet, just park it and return — DO NOT READ.
+        auto [peer, pdim] = room.add_and_try_pair(me, kind, dim);
+        if (peer.socks.empty()) {
             std::cout << "[server] queued; waiting for a peer in another thread\n";
             return; // keep socket alive via the shared_ptr held in room
         }
@@ -140,15 +247,22 @@ static void handle_one(PairingRoom& room, std::shared_ptr<tcp::socket> sock) {
 
         // Generate shares and send to both sockets.
         DuAtAllahServer gen(dim);
-        auto [p0, p1] = gen.getShares();
+        std::vector<ringArithmetic> f0, f1;
+        if (kind == TripleKind::Mul) {
+            auto [p0, p1] = gen.getMulShares();
+            f0 = to_frame(p0); f1 = to_frame(p1);
+        } else {
+            auto [p0, p1] = gen.getShares();
+            f0 = to_frame(p0); f1 = to_frame(p1);
+        }
 
         // single sid for both parties
         uint64_t sid = (static_cast<uint64_t>(std::random_device{}()) << 32)
                     ^ static_cast<uint64_t>(std::random_device{}());
 
         // first arrival gets p0, second gets p1
-        send_client_share(*peer, dim, sid, p0);
-        send_client_share(*sock , dim, sid, p1);
+        send_client_share(peer, dim, sid, f0);
+        send_client_share(me  , dim, sid, f1);
 
         std::cout << "[server] shares sent.\n";
 
@@ -162,6 +276,7 @@ static void handle_one(PairingRoom& room, std::shared_ptr<tcp::socket> sock) {
 int main(int argc, char** argv) {
     std::string listen_host = "0.0.0.0";
     std::string listen_port = "9300";
+    std::string tls_cert, tls_key, tls_ca;
 
     for (int i=1; i<argc; ++i) {
         std::string a = argv[i];
@@ -170,13 +285,26 @@ int main(int argc, char** argv) {
             auto pos = hp.find(':');
             if (pos == std::string::npos) listen_port = hp;
             else { listen_host = hp.substr(0, pos); listen_port = hp.substr(pos+1); }
+        } else if (a == "--tls-cert" && i+1 < argc) {
+            tls_cert = argv[++i];
+        } else if (a == "--tls-key" && i+1 < argc) {
+            tls_key = argv[++i];
+        } else if (a == "--tls-ca" && i+1 < argc) {
+            tls_ca = argv[++i];
         } else if (a == "--help") {
-            std::cout << "Usage: " << argv[0] << " --listen HOST:PORT\n";
+            std::cout << "Usage: " << argv[0] << " --listen HOST:PORT [--tls-cert PEM --tls-key PEM --tls-ca PEM]\n";
             return 0;
         }
     }
 
     try {
+        KtlsContext tls;
+        if (!tls_cert.empty() || !tls_key.empty() || !tls_ca.empty()) {
+            if (tls_cert.empty() || tls_key.empty() || tls_ca.empty())
+                throw std::runtime_error("--tls-cert, --tls-key and --tls-ca must be given together");
+            tls = KtlsContext(tls_cert, tls_key, tls_ca);
+        }
+
         boost::asio::io_context io;
         tcp::resolver res(io);
         tcp::acceptor acc(io);
@@ -188,14 +316,16 @@ int main(int argc, char** argv) {
         acc.bind(ep);
         acc.listen();
 
-        std::cout << "[server] listening on " << listen_host << ":" << listen_port << "\n";
+        std::cout << "[server] listening on " << listen_host << ":" << listen_port
+                  << (tls ? " (ktls)" : "") << "\n";
 
         PairingRoom room;
+        StripeGroups groups;
 
         for (;;) {
             auto sock = std::make_shared<tcp::socket>(io);
             acc.accept(*sock);
-            std::thread([&room, sock](){ handle_one(room, sock); }).detach();
+            std::thread([&room, &groups, &tls, sock](){ handle_one(room, groups, tls, sock); }).detach();
         }
 
     } catch (const std::exception& e) {
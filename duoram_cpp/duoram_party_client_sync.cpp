@@ -1,4 +1,7 @@
 #include "common.hpp"   // ringArithmetic, duoram
+#include "ktls.hpp"     // KtlsContext
+#include "striping.hpp" // plan_stripes, for_each_stripe
+#include "pcg.hpp"      // PcgParty
 #include <boost/asio.hpp>
 #include <cstdint>
 #include <cstring>
@@ -8,6 +11,11 @@
 #include <vector>
 #include <atomic>
 #include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <cerrno>
+#include <poll.h>
 
 using boost::asio::ip::tcp;
 
@@ -57,13 +65,51 @@ static inline void     write_be32_u32(tcp::socket& s, uint32_t v){ v = to_be32(v
 static inline uint64_t read_be64_u64(tcp::socket& s){ uint64_t be=0; read_all(s,&be,8); return from_be64(be); }
 static inline void     write_be64_u64(tcp::socket& s, uint64_t v){ v = to_be64(v); write_all(s,&v,8); }
 
+// One call per vector: a single write/read (and, under kTLS, full-size records)
+static inline void write_be32_range(tcp::socket& s, const ringArithmetic* p, std::size_t n){
+    std::vector<uint32_t> be(n);
+    for(std::size_t i=0;i<n;++i) be[i] = to_be32(static_cast<uint32_t>(p[i]));
+    write_all(s, be.data(), be.size()*4);
+}
+static inline void read_be32_into(tcp::socket& s, ringArithmetic* p, std::size_t n){
+    std::vector<uint32_t> be(n);
+    read_all(s, be.data(), be.size()*4);
+    for(std::size_t i=0;i<n;++i) p[i] = ringArithmetic(from_be32(be[i]));
+}
+static inline void write_be32_vec(tcp::socket& s, const std::vector<ringArithmetic>& v){ write_be32_range(s, v.data(), v.size()); }
+static inline std::vector<ringArithmetic> read_be32_vec(tcp::socket& s, uint32_t dim){
+    std::vector<ringArithmetic> r(dim);
+    read_be32_into(s, r.data(), dim);
+    return r;
+}
+
+// Link encryption for every outbound/inbound connection (disabled unless --tls-* given)
+static KtlsContext g_tls;
+// Parallel connections per large peer/dealer frame (--streams; 1 = no striping)
+static uint32_t g_streams = 1;
+// Generate triples with the peer instead of fetching them from the pairing server (--pcg)
+static bool g_pcg = false;
+// How long to wait for the peer's next connection before giving up on an op (--peer-timeout)
+static int g_peer_timeout_ms = 30000;
+
 static inline tcp::socket connect_to(boost::asio::io_context& io, const std::string& host, const std::string& port){
     tcp::resolver res(io);
     auto eps = res.resolve(host, port);
     tcp::socket sock(io);
     boost::asio::connect(sock, eps);
+    g_tls.client(sock);
     return sock;
 }
+static inline void accept_from(tcp::acceptor& acc, tcp::socket& sock){
+    // a peer that failed (or restarted) mid-op never connects; fail the op instead of hanging
+    pollfd pfd{acc.native_handle(), POLLIN, 0};
+    int r;
+    do{ r = ::poll(&pfd, 1, g_peer_timeout_ms); } while(r < 0 && errno == EINTR);
+    if(r < 0) throw std::runtime_error(std::string("peer accept: ") + std::strerror(errno));
+    if(r == 0) throw std::runtime_error("peer did not connect within " + std::to_string(g_peer_timeout_ms / 1000) + " s");
+    acc.accept(sock);
+    g_tls.server(sock);
+}
 
 // ===== ring utils =====
 static inline uint32_t raw31(const ringArithmetic& r){ return static_cast<uint32_t>(r); }
@@ -87,116 +133,414 @@ static inline std::vector<ringArithmetic> from_raw(const std::vector<uint32_t>&
 // ===== Correlated randomness (Du-Atallah) from pairing server =====
 struct DTAShare {
     uint32_t dim = 0;
+    uint64_t sid = 0;                // session id, identical for both parties
     std::vector<ringArithmetic> a_i; // my a_i
     std::vector<ringArithmetic> b_i; // my b_i
     ringArithmetic c_i;              // my c_i
 };
 
+// Element-wise multiplication triples: c_i[k] shares a[k]*b[k]
+struct MulShare {
+    uint32_t dim = 0;
+    uint64_t sid = 0;
+    std::vector<ringArithmetic> a_i, b_i, c_i;
+};
+
 enum : uint8_t {
-    OP_REQUEST  = 0x31, // client -> pairing server: [op][dim]
-    OP_RESPONSE = 0x33  // server -> client: [op][dim][X(dim)][Y(dim)][Z]
+    OP_REQUEST             = 0x31, // client -> pairing server: [op][dim]
+    OP_RESPONSE            = 0x33, // server -> client: [op][dim][sid][X(dim)][Y(dim)][Z]
+    OP_REQUEST_STRIPED     = 0x34, // client -> pairing server, one per stripe: [op][dim][nonce][k][n]
+                                   //   reply: [OP_RESPONSE][dim][sid][off][cnt][words of X||Y||Z]
+    OP_REQUEST_MUL         = 0x35, // as OP_REQUEST, but Z has dim words (element-wise triples)
+    OP_REQUEST_MUL_STRIPED = 0x36  // as OP_REQUEST_STRIPED for element-wise triples
 };
 
+// Raw X||Y||Z frame of `words` words; striped over parallel connections when large.
+static std::vector<ringArithmetic> fetch_frame(boost::asio::io_context& io,
+                                               const std::string& host, const std::string& port,
+                                               uint8_t op, uint8_t striped_op,
+                                               uint32_t dim, uint32_t words, uint64_t& sid)
+{
+    std::vector<ringArithmetic> buf(words);
+    auto stripes = plan_stripes(words, stripe_count(words, g_streams));
+    if(stripes.size() == 1){
+        auto s = connect_to(io, host, port);
+        write_u8(s, op);
+        write_be32_u32(s, dim);
+
+        if(read_u8(s) != OP_RESPONSE) throw std::runtime_error("pairing server: bad op");
+        if(read_be32_u32(s) != dim) throw std::runtime_error("pairing server: dim mismatch");
+        sid = read_be64_u64(s);
+        read_be32_into(s, buf.data(), words);
+        return buf;
+    }
+
+    const uint8_t  n = static_cast<uint8_t>(stripes.size());
+    const uint64_t nonce = (static_cast<uint64_t>(std::random_device{}()) << 32)
+                         ^ static_cast<uint64_t>(std::random_device{}());
+    std::vector<uint64_t> sids(n);
+
+    for_each_stripe(stripes, [&](std::size_t k, const Stripe& st){
+        auto s = connect_to(io, host, port);
+        write_u8(s, striped_op);
+        write_be32_u32(s, dim);
+        write_be64_u64(s, nonce);
+        write_u8(s, static_cast<uint8_t>(k));
+        write_u8(s, n);
+
+        if(read_u8(s) != OP_RESPONSE) throw std::runtime_error("pairing server: bad op");
+        if(read_be32_u32(s) != dim) throw std::runtime_error("pairing server: dim mismatch");
+        sids[k] = read_be64_u64(s);
+        uint32_t off = read_be32_u32(s), cnt = read_be32_u32(s);
+        if(off != st.off || cnt != st.cnt) throw std::runtime_error("pairing server: stripe mismatch");
+        read_be32_into(s, buf.data() + off, cnt);
+    });
+    for(uint8_t k=1;k<n;++k)
+        if(sids[k] != sids[0]) throw std::runtime_error("pairing server: stripes from different sessions");
+    sid = sids[0];
+    return buf;
+}
+
 static DTAShare fetch_dta_share(boost::asio::io_context& io,
                                 const std::string& host, const std::string& port,
                                 uint32_t dim)
 {
-    auto s = connect_to(io, host, port);
-    write_u8(s, OP_REQUEST);
-    write_be32_u32(s, dim);
+    DTAShare m; m.dim = dim;
+    auto buf = fetch_frame(io, host, port, OP_REQUEST, OP_REQUEST_STRIPED, dim, 2*dim + 1, m.sid);
+    m.a_i.assign(buf.begin(),       buf.begin() + dim);
+    m.b_i.assign(buf.begin() + dim, buf.begin() + 2*dim);
+    m.c_i = buf[2*dim];
+    return m;
+}
 
-    uint8_t op = read_u8(s);
-    if(op != OP_RESPONSE) throw std::runtime_error("pairing server: bad op");
-    uint32_t rdim = read_be32_u32(s);
-    if(rdim != dim) throw std::runtime_error("pairing server: dim mismatch");
+static MulShare fetch_mul_share(boost::asio::io_context& io,
+                                const std::string& host, const std::string& port,
+                                uint32_t dim)
+{
+    MulShare m; m.dim = dim;
+    auto buf = fetch_frame(io, host, port, OP_REQUEST_MUL, OP_REQUEST_MUL_STRIPED, dim, 3*dim, m.sid);
+    m.a_i.assign(buf.begin(),           buf.begin() + dim);
+    m.b_i.assign(buf.begin() + dim,     buf.begin() + 2*dim);
+    m.c_i.assign(buf.begin() + 2*dim,   buf.end());
+    return m;
+}
+
+// ===== Correlated randomness generated with the peer (--pcg, see pcg.hpp) =====
+// One generator per party, set up on first use (base OTs + IKNP, both
+// directions) and then expanded silently. Each triple runs on its own peer
+// connection: A connects and sends [session][TAG_PCG][t][kind][dim], B answers
+// [session][t]. If the two (session, t) differ, or either is 0 (a restarted
+// party, or one that dropped its generator after a failure), both parties
+// discard their state and set up a fresh session on this connection before
+// taking the triple. The sid is session + t.
+static constexpr uint8_t TAG_PCG = 0x21;
+struct PcgSession {
+    uint64_t id = 0;  // 0 = not set up yet
+    uint64_t t = 0;   // triples taken so far
+    std::unique_ptr<PcgParty> gen;
+};
+static PcgSession g_pcg_session;
+
+static PcgTriple pcg_triple(boost::asio::io_context& io, const std::string& my_role,
+                            const std::string& peer_host, const std::string& peer_port,
+                            tcp::acceptor& peer_acc, uint32_t dim, bool elementwise, uint64_t& sid)
+{
+    PcgSession& ps = g_pcg_session;
+    const uint8_t kind = elementwise ? 1 : 0;
+    tcp::socket s(io);
+    uint64_t peer_id = 0, peer_t = 0;
+    if(my_role=="A"){
+        s = connect_to(io, peer_host, peer_port);
+        write_be64_u64(s, ps.id);
+        write_u8(s, TAG_PCG);
+        write_be64_u64(s, ps.t);
+        write_u8(s, kind);
+        write_be32_u32(s, dim);
+        peer_id = read_be64_u64(s);
+        peer_t  = read_be64_u64(s);
+    }else{
+        accept_from(peer_acc, s);
+        peer_id = read_be64_u64(s);
+        if(read_u8(s) != TAG_PCG) throw std::runtime_error("pcg: unexpected peer message");
+        peer_t = read_be64_u64(s);
+        if(read_u8(s) != kind || read_be32_u32(s) != dim) throw std::runtime_error("pcg: peer asked for a different triple");
+        write_be64_u64(s, ps.id);
+        write_be64_u64(s, ps.t);
+    }
 
+    // Past the hello, a failure can leave the generator half-extended: drop it,
+    // so the next triple reopens the session instead of drifting.
+    try{
+        if(ps.id == 0 || peer_id != ps.id || peer_t != ps.t){
+            if(ps.id != 0 || peer_id != 0)
+                std::cerr << "[party " << my_role << "] pcg state differs from peer (session " << ps.id << ", triple " << ps.t
+                          << " vs " << peer_id << ", " << peer_t << "); reopening\n";
+            ps = PcgSession{};
+            uint64_t id = 0;
+            if(my_role=="A"){
+                while(id == 0) id = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+                write_be64_u64(s, id);
+            }else{
+                id = read_be64_u64(s);
+            }
+            auto gen = std::make_unique<PcgParty>(my_role=="A");
+            gen->setup(s);
+            ps.gen = std::move(gen);
+            ps.id = id;
+            ps.t = 0;
+            std::cout << "[party " << my_role << "] pcg session " << id << " set up with peer\n";
+        }
+
+        PcgTriple tr = ps.gen->triple(s, dim, elementwise);
+        sid = ps.id + ps.t;
+        ++ps.t;
+        return tr;
+    } catch(...){
+        ps = PcgSession{};
+        throw;
+    }
+}
+
+static DTAShare pcg_dta_share(boost::asio::io_context& io, const std::string& my_role,
+                              const std::string& peer_host, const std::string& peer_port,
+                              tcp::acceptor& peer_acc, uint32_t dim)
+{
     DTAShare m; m.dim = dim;
-    m.a_i.resize(dim); m.b_i.resize(dim);
-    for(uint32_t i=0;i<dim;++i) m.a_i[i] = ringArithmetic(read_be32_u32(s));
-    for(uint32_t i=0;i<dim;++i) m.b_i[i] = ringArithmetic(read_be32_u32(s));
-    m.c_i = ringArithmetic(read_be32_u32(s));
+    PcgTriple tr = pcg_triple(io, my_role, peer_host, peer_port, peer_acc, dim, false, m.sid);
+    m.a_i = std::move(tr.a);
+    m.b_i = std::move(tr.b);
+    m.c_i = tr.c[0];
+    return m;
+}
+
+static MulShare pcg_mul_share(boost::asio::io_context& io, const std::string& my_role,
+                              const std::string& peer_host, const std::string& peer_port,
+                              tcp::acceptor& peer_acc, uint32_t dim)
+{
+    MulShare m; m.dim = dim;
+    PcgTriple tr = pcg_triple(io, my_role, peer_host, peer_port, peer_acc, dim, true, m.sid);
+    m.a_i = std::move(tr.a);
+    m.b_i = std::move(tr.b);
+    m.c_i = std::move(tr.c);
     return m;
 }
 
 // ===== Peer residual exchange =====
+// Each connection carries one stripe: [sid][tag][dim][n][off][cnt][cnt words]
 static void send_vec(boost::asio::io_context& io,
                      const std::string& peer_host, const std::string& peer_port,
                      uint64_t sid, uint8_t tag,
                      const std::vector<ringArithmetic>& v)
 {
-    auto s = connect_to(io, peer_host, peer_port);
-    write_be64_u64(s, sid);
-    write_u8(s, tag);
-    write_be32_u32(s, static_cast<uint32_t>(v.size()));
-    for(const auto& w: v) write_be32_u32(s, static_cast<uint32_t>(w));
+    const uint32_t dim = static_cast<uint32_t>(v.size());
+    auto stripes = plan_stripes(dim, stripe_count(dim, g_streams));
+    const uint8_t n = static_cast<uint8_t>(stripes.size());
+    for_each_stripe(stripes, [&](std::size_t, const Stripe& st){
+        auto s = connect_to(io, peer_host, peer_port);
+        write_be64_u64(s, sid);
+        write_u8(s, tag);
+        write_be32_u32(s, dim);
+        write_u8(s, n);
+        write_be32_u32(s, st.off);
+        write_be32_u32(s, st.cnt);
+        write_be32_range(s, v.data() + st.off, st.cnt);
+    });
 }
 
 static std::vector<ringArithmetic> recv_vec(boost::asio::io_context& io,
                                             tcp::acceptor& peer_acc,
                                             uint64_t expect_sid, uint8_t expect_tag, uint32_t expect_dim)
 {
-    tcp::socket s(io);
-    peer_acc.accept(s);
-    uint64_t sid = read_be64_u64(s);
-    uint8_t  tag = read_u8(s);
-    uint32_t dim = read_be32_u32(s);
-    if(sid!=expect_sid || tag!=expect_tag || dim!=expect_dim)
-        throw std::runtime_error("peer residual header mismatch");
-    std::vector<ringArithmetic> r(dim);
-    for(uint32_t i=0;i<dim;++i) r[i] = ringArithmetic(read_be32_u32(s));
+    std::vector<ringArithmetic> r(expect_dim);
+    std::vector<std::shared_ptr<tcp::socket>> socks;
+    std::vector<std::future<void>> bodies;
+    try{
+        // All headers are read (in accept order) and the layout validated before
+        // any body is read; stripe bodies then drain concurrently.
+        uint32_t n = 1;
+        std::vector<std::pair<Stripe, std::shared_ptr<tcp::socket>>> parts;
+        for(uint32_t k=0;k<n;++k){
+            auto s = std::make_shared<tcp::socket>(io);
+            socks.push_back(s);
+            accept_from(peer_acc, *s);
+            uint64_t sid = read_be64_u64(*s);
+            uint8_t  tag = read_u8(*s);
+            uint32_t dim = read_be32_u32(*s);
+            uint8_t  ns  = read_u8(*s);
+            uint32_t off = read_be32_u32(*s);
+            uint32_t cnt = read_be32_u32(*s);
+            if(sid!=expect_sid || tag!=expect_tag || dim!=expect_dim)
+                throw std::runtime_error("peer residual header mismatch");
+            if(k==0){
+                if(ns==0 || ns>STRIPE_MAX) throw std::runtime_error("peer residual: bad stripe count");
+                n = ns;
+            }
+            else if(ns!=n) throw std::runtime_error("peer residual: stripe count mismatch");
+            parts.push_back({Stripe{off, cnt}, s});
+        }
+        // Stripes must tile [0, dim) exactly: no gaps, no overlaps.
+        std::sort(parts.begin(), parts.end(),
+                  [](const auto& x, const auto& y){ return x.first.off < y.first.off; });
+        uint32_t next = 0;
+        for(const auto& [st, s]: parts){
+            if(st.off != next || st.cnt > expect_dim - next)
+                throw std::runtime_error("peer residual: stripes do not tile the frame");
+            next += st.cnt;
+        }
+        if(next != expect_dim) throw std::runtime_error("peer residual: stripes do not tile the frame");
+        for(const auto& [st, s]: parts)
+            bodies.push_back(std::async(std::launch::async,
+                [s, p = r.data() + st.off, cnt = st.cnt]{ read_be32_into(*s, p, cnt); }));
+        for(auto& b: bodies) b.get();
+    } catch(...){
+        // unblock any stripe reader still waiting before the futures are joined
+        for(auto& s: socks){ boost::system::error_code ec; s->shutdown(tcp::socket::shutdown_both, ec); }
+        throw;
+    }
     return r;
 }
 
-// ===== Online phase for one inner-product <x, y> =====
-// Party A = role "A" (index 0)     uses s_A =    - <u, b_A> - <a_A, v> + c_A
-// Party B = role "B" (index 1)     uses s_B = <u, v> - <u, b_B> - <a_B, v> + c_B
-// with u = x + a_i (sent by X-side), v = y + b_j (sent by Y-side).
-static ringArithmetic dta_cross(boost::asio::io_context& io,
-                                const std::string& my_role,             // "A" or "B"
-                                const std::string& peer_host, const std::string& peer_port,
-                                tcp::acceptor& peer_acc,
-                                uint64_t sid, uint8_t tag,
-                                bool i_am_X_side,                        // true: I send u; false: I send v
-                                const std::vector<ringArithmetic>& my_input, // x if X-side, y if Y-side
-                                const std::vector<ringArithmetic>& a_i,  // my a_i
-                                const std::vector<ringArithmetic>& b_i,  // my b_i
-                                const ringArithmetic& c_i)
+// ===== Online phase for one inner-product <x, y> of two shared vectors =====
+// x = x_A + x_B and y = y_A + y_B are both additively shared; the dealer triple
+// gives a_i, b_i, c_i with c_A + c_B = <a_A + a_B, b_A + b_B>.
+// Each party publishes d_i = x_i - a_i and e_i = y_i - b_i in one exchange, so
+// d = x - a and e = y - b are opened, and
+//     <x, y> = <d, e> + <d, b> + <a, e> + <a, b>
+// Party A uses z_A = <d, e> + <d, b_A> + <a_A, e> + c_A
+// Party B uses z_B =          <d, b_B> + <a_B, e> + c_B
+// This covers the self terms <x_i, y_i> and both cross terms in a single pass
+// with a single triple. A sends first, B answers.
+static ringArithmetic dta_dot(boost::asio::io_context& io,
+                              const std::string& my_role,             // "A" or "B"
+                              const std::string& peer_host, const std::string& peer_port,
+                              tcp::acceptor& peer_acc,
+                              uint64_t sid, uint8_t tag,
+                              const std::vector<ringArithmetic>& x_i,  // my share of x
+                              const std::vector<ringArithmetic>& y_i,  // my share of y
+                              const DTAShare& dta)
 {
-    const uint32_t dim = static_cast<uint32_t>(my_input.size());
-
-    std::vector<ringArithmetic> mine(dim);
-    if(i_am_X_side){
-        for(uint32_t i=0;i<dim;++i) mine[i] = my_input[i] + a_i[i]; // u
+    const uint32_t dim = static_cast<uint32_t>(x_i.size());
+    if(y_i.size()!=dim || dta.a_i.size()!=dim || dta.b_i.size()!=dim)
+        throw std::runtime_error("dta_dot: size mismatch");
+
+    // [d_i || e_i]
+    std::vector<ringArithmetic> mine(2*static_cast<std::size_t>(dim));
+    for(uint32_t k=0;k<dim;++k){
+        mine[k]       = x_i[k] - dta.a_i[k];
+        mine[dim + k] = y_i[k] - dta.b_i[k];
+    }
+    std::vector<ringArithmetic> peer;
+    if(my_role=="A"){
         send_vec(io, peer_host, peer_port, sid, tag, mine);
-        auto peer_v = recv_vec(io, peer_acc, sid, tag, dim);        // v
-        // s = role-dependent
-        ringArithmetic s(0);
-        if(my_role=="A"){
-            s = ringArithmetic(0) - dot_ra(mine, b_i) - dot_ra(a_i, peer_v) + c_i;
-        }else{
-            s = dot_ra(mine, peer_v) - dot_ra(mine, b_i) - dot_ra(a_i, peer_v) + c_i;
-        }
-        return s;
+        peer = recv_vec(io, peer_acc, sid, tag, 2*dim);
     }else{
-        for(uint32_t i=0;i<dim;++i) mine[i] = my_input[i] + b_i[i]; // v
-        auto peer_u = recv_vec(io, peer_acc, sid, tag, dim);        // u
+        peer = recv_vec(io, peer_acc, sid, tag, 2*dim);
         send_vec(io, peer_host, peer_port, sid, tag, mine);
-        ringArithmetic s(0);
-        if(my_role=="A"){
-            s = ringArithmetic(0) - dot_ra(peer_u, b_i) - dot_ra(a_i, mine) + c_i;
-        }else{
-            s = dot_ra(peer_u, mine) - dot_ra(peer_u, b_i) - dot_ra(a_i, mine) + c_i;
+    }
+
+    const bool add_de = (my_role=="A");
+    ringArithmetic z = dta.c_i;
+    for(uint32_t k=0;k<dim;++k){
+        const ringArithmetic d = mine[k] + peer[k];
+        const ringArithmetic e = mine[dim + k] + peer[dim + k];
+        z += d*dta.b_i[k] + dta.a_i[k]*e;
+        if(add_de) z += d*e;
+    }
+    return z;
+}
+
+// ===== Online phase for an element-wise product x ⊙ y of two shared vectors =====
+// Same opening as dta_dot, but per row with the element-wise triple (c = a ⊙ b):
+// Party A uses z_A[k] = d[k]e[k] + d[k]b_A[k] + a_A[k]e[k] + c_A[k]
+// Party B uses z_B[k] =            d[k]b_B[k] + a_B[k]e[k] + c_B[k]
+// One peer exchange of [d_i || e_i] for the whole vector, then a row-parallel pass.
+static std::vector<ringArithmetic> dta_mul(boost::asio::io_context& io,
+                                           const std::string& my_role,
+                                           const std::string& peer_host, const std::string& peer_port,
+                                           tcp::acceptor& peer_acc,
+                                           uint64_t sid, uint8_t tag,
+                                           const std::vector<ringArithmetic>& x_i,
+                                           const std::vector<ringArithmetic>& y_i,
+                                           const MulShare& t)
+{
+    const uint32_t dim = static_cast<uint32_t>(x_i.size());
+    if(y_i.size()!=dim || t.a_i.size()!=dim || t.b_i.size()!=dim || t.c_i.size()!=dim)
+        throw std::runtime_error("dta_mul: size mismatch");
+
+    std::vector<ringArithmetic> mine(2*static_cast<std::size_t>(dim));
+    parallel_rows(dim, [&](std::size_t lo, std::size_t hi){
+        for(std::size_t k=lo;k<hi;++k){
+            mine[k]       = x_i[k] - t.a_i[k];
+            mine[dim + k] = y_i[k] - t.b_i[k];
         }
-        return s;
+    });
+    std::vector<ringArithmetic> peer;
+    if(my_role=="A"){
+        send_vec(io, peer_host, peer_port, sid, tag, mine);
+        peer = recv_vec(io, peer_acc, sid, tag, 2*dim);
+    }else{
+        peer = recv_vec(io, peer_acc, sid, tag, 2*dim);
+        send_vec(io, peer_host, peer_port, sid, tag, mine);
     }
+
+    // raw 32-bit wraparound, masked once per row (see duoram::combine)
+    const uint32_t de = (my_role=="A") ? 1u : 0u;
+    std::vector<ringArithmetic> z(dim);
+    parallel_rows(dim, [&](std::size_t lo, std::size_t hi){
+        for(std::size_t k=lo;k<hi;++k){
+            const uint32_t d = mine[k].value + peer[k].value;
+            const uint32_t e = mine[dim + k].value + peer[dim + k].value;
+            z[k].value = (de*d*e + d*t.b_i[k].value + t.a_i[k].value*e + t.c_i[k].value) & ringArithmetic::MASK;
+        }
+    });
+    return z;
 }
 
 // ===== User request ops =====
 enum : uint8_t {
-    OP_WRITE_VEC   = 0x40,
-    OP_READ_SECURE = 0x41
+    OP_WRITE_VEC   = 0x40, // [op][dim][vec]                     -> "OK"   (table 0)
+    OP_READ_SECURE = 0x41, // [op][dim][e-share]                 -> share  (table 0)
+    OP_SCALE       = 0x42, // [op][opid:be64][table][k]          -> "OK"   table := k*table
+    OP_ADD_PUBLIC  = 0x43, // [op][opid:be64][table][dim][vec]   -> "OK"   table := table + vec
+    OP_WRITE_TABLE = 0x44, // [op][table][dim][vec]              -> "OK"
+    OP_READ_TABLE  = 0x45, // [op][table][dim][e-share]          -> share
+    OP_COMBINE     = 0x46, // [op][opid:be64][dst][x][y][a][b]   -> "OK"   dst := a*x + b*y
+    OP_DOT_TABLES  = 0x47, // [op][opid:be64][x][y]              -> share of <x, y>
+    OP_MUL_TABLES  = 0x48  // [op][opid:be64][dst][x][y]         -> "OK"   dst := x ⊙ y
+};
+
+// ===== Shared tables =====
+// All tables have --rows rows; table 0 is the one OP_WRITE_VEC/OP_READ_SECURE address.
+// epoch counts the mutations applied to a table, so both parties can confirm they
+// hold matching states before a (non-commuting) linear transform.
+struct Table {
+    duoram ram;
+    uint32_t epoch = 0;
 };
 
+// ===== Epoch sync for linear transforms =====
+// Each party sends a digest of (op, tables, epochs, public params, local ok) and
+// applies the transform only if both digests agree and local ok is 1, so the
+// parties either both move to the next epoch or both refuse. local ok is the
+// outcome of every check the party can make on its own (tables present, ...);
+// those checks all run before the sync, never after it. A sends first, B answers.
+static constexpr uint8_t TAG_SYNC = 0x20;
+static void sync_with_peer(boost::asio::io_context& io, const std::string& my_role,
+                           const std::string& peer_host, const std::string& peer_port,
+                           tcp::acceptor& peer_acc, uint64_t opid,
+                           const std::vector<ringArithmetic>& digest)
+{
+    std::vector<ringArithmetic> theirs;
+    if(my_role=="A"){
+        send_vec(io, peer_host, peer_port, opid, TAG_SYNC, digest);
+        theirs = recv_vec(io, peer_acc, opid, TAG_SYNC, static_cast<uint32_t>(digest.size()));
+    }else{
+        theirs = recv_vec(io, peer_acc, opid, TAG_SYNC, static_cast<uint32_t>(digest.size()));
+        send_vec(io, peer_host, peer_port, opid, TAG_SYNC, digest);
+    }
+    if(theirs != digest) throw std::runtime_error("transform rejected: peer table state/epoch differs");
+}
+
 int main(int argc, char** argv){
     // CLI
     std::string role = "A";                  // A or B
@@ -206,6 +550,7 @@ int main(int argc, char** argv){
     std::string peer_host = "127.0.0.1", peer_port = "9801"; // peer's residual listener
     std::string share_host = "127.0.0.1", share_port = "9300"; // pairing server
     std::size_t rows = 0;
+    std::string tls_cert, tls_key, tls_ca;
 
     for(int i=1;i<argc;++i){
         std::string a = argv[i];
@@ -216,10 +561,17 @@ int main(int argc, char** argv){
         else if(a=="--peer-listen"){ need(1); peer_listen_port = argv[++i]; }
         else if(a=="--peer"){ need(1); std::string hp=argv[++i]; auto p=hp.find(':'); if(p==std::string::npos){ peer_port=hp; } else { peer_host=hp.substr(0,p); peer_port=hp.substr(p+1);} }
         else if(a=="--share"){ need(1); std::string hp=argv[++i]; auto p=hp.find(':'); if(p==std::string::npos){ share_port=hp; } else { share_host=hp.substr(0,p); share_port=hp.substr(p+1);} }
+        else if(a=="--pcg"){ g_pcg = true; }
+        else if(a=="--peer-timeout"){ need(1); g_peer_timeout_ms = 1000 * std::stoi(argv[++i]); if(g_peer_timeout_ms<=0) throw std::runtime_error("--peer-timeout must be > 0"); }
+        else if(a=="--streams"){ need(1); g_streams = parse_streams(argv[++i]); }
+        else if(a=="--tls-cert"){ need(1); tls_cert = argv[++i]; }
+        else if(a=="--tls-key"){ need(1); tls_key = argv[++i]; }
+        else if(a=="--tls-ca"){ need(1); tls_ca = argv[++i]; }
         else if(a=="--help"){
             std::cout <<
               "Usage: " << argv[0] << " --role A|B --rows N [--listen H:P] [--peer-listen P]\n"
-              "                         [--peer H:P] [--share H:P]\n";
+              "                         [--peer H:P] [--share H:P] [--streams N|auto] [--pcg] [--peer-timeout S]\n"
+              "                         [--tls-cert PEM --tls-key PEM --tls-ca PEM]  (kTLS on all links)\n";
             return 0;
         }
     }
@@ -227,6 +579,12 @@ int main(int argc, char** argv){
     if(!(role=="A" || role=="B")) { std::cerr<<"--role must be A or B\n"; return 1; }
 
     try{
+        if(!tls_cert.empty() || !tls_key.empty() || !tls_ca.empty()){
+            if(tls_cert.empty() || tls_key.empty() || tls_ca.empty())
+                throw std::runtime_error("--tls-cert, --tls-key and --tls-ca must be given together");
+            g_tls = KtlsContext(tls_cert, tls_key, tls_ca);
+        }
+
         boost::asio::io_context io;
 
         // User acceptor
@@ -252,71 +610,189 @@ int main(int argc, char** argv){
                   << " | residual-in @:" << peer_listen_port
                   << " | peer=" << peer_host << ":" << peer_port
                   << " | share=" << share_host << ":" << share_port
-                  << " | rows=" << rows << "\n";
-
-        duoram ram; ram.initialize(rows);
+                  << " | rows=" << rows
+                  << " | streams=" << (g_streams==STRIPE_AUTO ? std::string("auto") : std::to_string(g_streams))
+                  << (g_pcg ? " | pcg" : "")
+                  << (g_tls ? " | ktls" : "") << "\n";
+
+        std::map<uint32_t, Table> tables;
+        tables[0].ram.initialize(rows);
+        // created zero-filled on first write; reads of unknown tables fail
+        auto table_rw = [&](uint32_t id) -> Table& {
+            Table& t = tables[id];
+            if(t.ram.get_rows()==0) t.ram.initialize(rows);
+            return t;
+        };
+        auto table_ro = [&](uint32_t id) -> Table& {
+            auto it = tables.find(id);
+            if(it==tables.end()) throw std::runtime_error("no such table " + std::to_string(id));
+            return it->second;
+        };
+        // digest word for a table that must already exist
+        constexpr uint32_t NO_TABLE = ringArithmetic::MASK;
+        auto epoch_of = [&](uint32_t id) -> uint32_t {
+            auto it = tables.find(id);
+            return it==tables.end() ? NO_TABLE : it->second.epoch;
+        };
+        const char ok[2]={'O','K'};
 
         for(;;){
             tcp::socket user(io);
             acc.accept(user);
             try{
+                g_tls.server(user);
                 uint8_t op = read_u8(user);
 
-                if(op==OP_WRITE_VEC){
+                if(op==OP_WRITE_VEC || op==OP_WRITE_TABLE){
+                    uint32_t tid = (op==OP_WRITE_TABLE) ? read_be32_u32(user) : 0;
                     uint32_t dim = read_be32_u32(user);
-                    if(dim != ram.get_rows()) throw std::runtime_error("WRITE dim != rows");
-                    std::vector<ringArithmetic> raw(dim);
-                    for(uint32_t i=0;i<dim;++i) raw[i] = ringArithmetic(read_be32_u32(user));
-                    ram.obliviousWrite(raw);
-                    const char ok[2]={'O','K'}; write_all(user, ok, 2);
-                    std::cout << "[party " << role << "] wrote vector of dim " << dim << "\n";
+                    if(dim != rows) throw std::runtime_error("WRITE dim != rows");
+                    std::vector<ringArithmetic> raw = read_be32_vec(user, dim);
+                    Table& t = table_rw(tid);
+                    t.ram.obliviousWrite(raw);
+                    ++t.epoch;
+                    write_all(user, ok, 2);
+                    std::cout << "[party " << role << "] wrote vector of dim " << dim << " to table " << tid << "\n";
+                }
+                else if(op==OP_SCALE){
+                    uint64_t opid = read_be64_u64(user);
+                    uint32_t tid  = read_be32_u32(user);
+                    ringArithmetic k(read_be32_u32(user));
+
+                    const uint32_t local_ok = tables.count(tid) ? 1u : 0u;
+                    sync_with_peer(io, role, peer_host, peer_port, peer_acc, opid,
+                                   { ringArithmetic(uint32_t{op}), ringArithmetic(tid),
+                                     ringArithmetic(epoch_of(tid)), k, ringArithmetic(local_ok) });
+                    if(!local_ok) throw std::runtime_error("SCALE: no such table " + std::to_string(tid));
+                    Table& t = table_ro(tid);
+                    t.ram.scale(k);
+                    ++t.epoch;
+                    write_all(user, ok, 2);
+                    std::cout << "[party " << role << "] table " << tid << " *= " << k << " (epoch " << t.epoch << ")\n";
+                }
+                else if(op==OP_ADD_PUBLIC){
+                    uint64_t opid = read_be64_u64(user);
+                    uint32_t tid  = read_be32_u32(user);
+                    uint32_t dim  = read_be32_u32(user);
+                    if(dim != rows) throw std::runtime_error("ADD_PUBLIC dim != rows");
+                    std::vector<ringArithmetic> pub = read_be32_vec(user, dim);
+
+                    // public vector is added once (by A); both parties still check they agree on it
+                    ringArithmetic sum(0), wsum(0);
+                    for(uint32_t i=0;i<dim;++i){ sum += pub[i]; wsum += ringArithmetic(i+1) * pub[i]; }
+                    const uint32_t local_ok = tables.count(tid) ? 1u : 0u;
+                    sync_with_peer(io, role, peer_host, peer_port, peer_acc, opid,
+                                   { ringArithmetic(uint32_t{op}), ringArithmetic(tid),
+                                     ringArithmetic(epoch_of(tid)), ringArithmetic(dim), sum, wsum,
+                                     ringArithmetic(local_ok) });
+                    if(!local_ok) throw std::runtime_error("ADD_PUBLIC: no such table " + std::to_string(tid));
+                    Table& t = table_ro(tid);
+                    if(role=="A") t.ram.obliviousWrite(pub);
+                    ++t.epoch;
+                    write_all(user, ok, 2);
+                    std::cout << "[party " << role << "] table " << tid << " += public vector (epoch " << t.epoch << ")\n";
                 }
-                else if(op==OP_READ_SECURE){
+                else if(op==OP_COMBINE){
+                    uint64_t opid = read_be64_u64(user);
+                    uint32_t dst = read_be32_u32(user), x = read_be32_u32(user), y = read_be32_u32(user);
+                    ringArithmetic a(read_be32_u32(user)), b(read_be32_u32(user));
+
+                    // dst may be new; both sources must exist
+                    const uint32_t local_ok = (tables.count(x) && tables.count(y)) ? 1u : 0u;
+                    sync_with_peer(io, role, peer_host, peer_port, peer_acc, opid,
+                                   { ringArithmetic(uint32_t{op}), ringArithmetic(dst), ringArithmetic(x), ringArithmetic(y),
+                                     ringArithmetic(tables.count(dst) ? tables[dst].epoch : 0u),
+                                     ringArithmetic(epoch_of(x)), ringArithmetic(epoch_of(y)), a, b,
+                                     ringArithmetic(local_ok) });
+                    if(!local_ok) throw std::runtime_error("COMBINE: no such source table");
+                    const Table& tx = table_ro(x);
+                    const Table& ty = table_ro(y);
+                    Table& td = table_rw(dst);
+                    td.ram.combine(a, tx.ram, b, ty.ram);
+                    ++td.epoch;
+                    write_all(user, ok, 2);
+                    std::cout << "[party " << role << "] table " << dst << " = " << a << "*t" << x
+                              << " + " << b << "*t" << y << " (epoch " << td.epoch << ")\n";
+                }
+                else if(op==OP_READ_SECURE || op==OP_READ_TABLE){
+                    uint32_t tid = (op==OP_READ_TABLE) ? read_be32_u32(user) : 0;
                     uint32_t dim = read_be32_u32(user);
-                    if(dim != ram.get_rows()) throw std::runtime_error("READ dim != rows");
-                    std::vector<ringArithmetic> e_share(dim);
-                    for(uint32_t i=0;i<dim;++i) e_share[i] = ringArithmetic(read_be32_u32(user));
+                    if(dim != rows) throw std::runtime_error("READ dim != rows");
+                    std::vector<ringArithmetic> e_share = read_be32_vec(user, dim);
+                    const duoram& ram = table_ro(tid).ram;
 
-                    std::cout<<"[party "<<role<<"] READ_SECURE dim "<<dim<<"\n";
+                    std::cout<<"[party "<<role<<"] READ_SECURE dim "<<dim<<" table "<<tid<<"\n";
 
                     // Fetch fresh DTA shares for this session (pairing server pairs both parties)
-                    DTAShare dta = fetch_dta_share(io, share_host, share_port, dim);
+                    DTAShare dta = g_pcg ? pcg_dta_share(io, role, peer_host, peer_port, peer_acc, dim)
+                                         : fetch_dta_share(io, share_host, share_port, dim);
 
                     // Local A_share vector
                     std::vector<ringArithmetic> A_share(dim);
-                    for(uint32_t i=0;i<dim;++i) A_share[i] = ram.read(i);
-
-                    // Unique session id
-                    static std::atomic<uint64_t> g_ctr{0};
-                    static uint64_t g_epoch = []{
-                        uint64_t t = static_cast<uint64_t>(
-                            std::chrono::steady_clock::now().time_since_epoch().count());
-                        uint64_t r = (static_cast<uint64_t>(std::random_device{}()) << 32)
-                                   ^ static_cast<uint64_t>(std::random_device{}());
-                        return t ^ r;
-                    }();
-                    uint64_t sid = (g_epoch ^ (++g_ctr)) ^ static_cast<uint64_t>(dim);
-
-                    // Cross-term 01: <A_i (me), e_j (peer)>
-                    ringArithmetic z01 = dta_cross(io, role, peer_host, peer_port, peer_acc,
-                                                   sid, 0x01,
-                                                   /*i_am_X_side=*/(role=="A"),
-                                                   (role=="A" ? A_share : e_share), // A sends x, B sends y
-                                                   dta.a_i, dta.b_i, dta.c_i);
-
-                    // Cross-term 10: <A_j (peer), e_i (me)>
-                    ringArithmetic z10 = dta_cross(io, role, peer_host, peer_port, peer_acc,
-                                                   sid, 0x10,
-                                                   /*i_am_X_side=*/(role=="B"),
-                                                   (role=="B" ? A_share : e_share), // B sends x, A sends y
-                                                   dta.a_i, dta.b_i, dta.c_i);
-
-                    // Self term: <A_i, e_i>
-                    ringArithmetic self = dot_ra(A_share, e_share);
-
-                    ringArithmetic my_share = self + z01 + z10;
+                    for(uint32_t i=0;i<dim;++i) A_share[i] = ram[i];
+
+                    // <A, e> with both operands shared; session id comes from the pairing server
+                    ringArithmetic my_share = dta_dot(io, role, peer_host, peer_port, peer_acc,
+                                                      dta.sid, 0x01, A_share, e_share, dta);
                     write_be32_u32(user, static_cast<uint32_t>(my_share));
                 }
+                else if(op==OP_DOT_TABLES){
+                    uint64_t opid = read_be64_u64(user);
+                    uint32_t x = read_be32_u32(user), y = read_be32_u32(user);
+
+                    // both parties take a triple, or neither does
+                    const uint32_t local_ok = (tables.count(x) && tables.count(y)) ? 1u : 0u;
+                    sync_with_peer(io, role, peer_host, peer_port, peer_acc, opid,
+                                   { ringArithmetic(uint32_t{op}), ringArithmetic(x), ringArithmetic(y),
+                                     ringArithmetic(epoch_of(x)), ringArithmetic(epoch_of(y)),
+                                     ringArithmetic(local_ok) });
+                    if(!local_ok) throw std::runtime_error("DOT: no such table");
+                    const duoram& tx = table_ro(x).ram;
+                    const duoram& ty = table_ro(y).ram;
+
+                    std::cout<<"[party "<<role<<"] DOT tables "<<x<<"."<<y<<" dim "<<rows<<"\n";
+
+                    const uint32_t dim = static_cast<uint32_t>(rows);
+                    DTAShare dta = g_pcg ? pcg_dta_share(io, role, peer_host, peer_port, peer_acc, dim)
+                                         : fetch_dta_share(io, share_host, share_port, dim);
+                    std::vector<ringArithmetic> x_i(dim), y_i(dim);
+                    for(uint32_t i=0;i<dim;++i){ x_i[i] = tx[i]; y_i[i] = ty[i]; }
+
+                    ringArithmetic my_share = dta_dot(io, role, peer_host, peer_port, peer_acc,
+                                                      dta.sid, 0x02, x_i, y_i, dta);
+                    write_be32_u32(user, static_cast<uint32_t>(my_share));
+                }
+                else if(op==OP_MUL_TABLES){
+                    uint64_t opid = read_be64_u64(user);
+                    uint32_t dst = read_be32_u32(user), x = read_be32_u32(user), y = read_be32_u32(user);
+
+                    // as COMBINE: dst may be new, both sources must exist
+                    const uint32_t local_ok = (tables.count(x) && tables.count(y)) ? 1u : 0u;
+                    sync_with_peer(io, role, peer_host, peer_port, peer_acc, opid,
+                                   { ringArithmetic(uint32_t{op}), ringArithmetic(dst), ringArithmetic(x), ringArithmetic(y),
+                                     ringArithmetic(tables.count(dst) ? tables[dst].epoch : 0u),
+                                     ringArithmetic(epoch_of(x)), ringArithmetic(epoch_of(y)),
+                                     ringArithmetic(local_ok) });
+                    if(!local_ok) throw std::runtime_error("MUL: no such source table");
+                    const uint32_t dim = static_cast<uint32_t>(rows);
+                    std::vector<ringArithmetic> x_i(dim), y_i(dim);
+                    {
+                        const duoram& tx = table_ro(x).ram;
+                        const duoram& ty = table_ro(y).ram;
+                        for(uint32_t i=0;i<dim;++i){ x_i[i] = tx[i]; y_i[i] = ty[i]; }
+                    }
+
+                    std::cout<<"[party "<<role<<"] MUL tables "<<x<<"*"<<y<<" -> "<<dst<<" dim "<<dim<<"\n";
+
+                    MulShare trip = g_pcg ? pcg_mul_share(io, role, peer_host, peer_port, peer_acc, dim)
+                                          : fetch_mul_share(io, share_host, share_port, dim);
+                    std::vector<ringArithmetic> z = dta_mul(io, role, peer_host, peer_port, peer_acc,
+                                                            trip.sid, 0x03, x_i, y_i, trip);
+                    Table& td = table_rw(dst);
+                    for(uint32_t i=0;i<dim;++i) td.ram[i] = z[i];
+                    ++td.epoch;
+                    write_all(user, ok, 2);
+                }
                 else{
                     throw std::runtime_error("unknown op");
                 }
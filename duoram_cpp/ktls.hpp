@@ -0,0 +1,74 @@
+#pragma once
+// Kernel TLS (kTLS) for the party, peer and dealer links.
+//
+// The handshake runs in user space through OpenSSL; once it completes the
+// record layer is handed to the kernel (SSL_OP_ENABLE_KTLS) and the SSL object
+// is dropped. From then on the plain tcp::socket *is* the encrypted channel:
+// the existing read_all/write_all helpers keep working unchanged, bulk share
+// vectors are encrypted in-kernel straight from the caller's buffer, and
+// sendfile() stays available.
+#include <boost/asio.hpp>
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+class KtlsContext {
+public:
+    // Default: TLS disabled, handshakes are no-ops.
+    KtlsContext() = default;
+
+    // Mutual TLS: every endpoint presents cert/key and verifies its peer against ca.
+    KtlsContext(const std::string& cert, const std::string& key, const std::string& ca){
+        ctx_.reset(SSL_CTX_new(TLS_method()), SSL_CTX_free);
+        if(!ctx_) fail("SSL_CTX_new");
+        SSL_CTX* c = ctx_.get();
+
+        // OpenSSL 3.0 only offloads TLS 1.3 in the TX direction; TLS 1.2 AES-GCM
+        // is offloaded both ways, which is what we need for raw-socket reads.
+        SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+        SSL_CTX_set_max_proto_version(c, TLS1_2_VERSION);
+        if(SSL_CTX_set_cipher_list(c, "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                      "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384") != 1)
+            fail("cipher list");
+        // Nothing may arrive as a non-data record once the kernel owns the socket.
+        SSL_CTX_set_options(c, SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION | SSL_OP_NO_TICKET);
+
+        if(SSL_CTX_use_certificate_chain_file(c, cert.c_str()) != 1) fail("load cert " + cert);
+        if(SSL_CTX_use_PrivateKey_file(c, key.c_str(), SSL_FILETYPE_PEM) != 1) fail("load key " + key);
+        if(SSL_CTX_check_private_key(c) != 1) fail("cert/key mismatch");
+        if(SSL_CTX_load_verify_locations(c, ca.c_str(), nullptr) != 1) fail("load CA " + ca);
+        SSL_CTX_set_verify(c, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
+    }
+
+    explicit operator bool() const { return static_cast<bool>(ctx_); }
+
+    // Run the handshake on a connected socket and switch it to kTLS.
+    void client(boost::asio::ip::tcp::socket& s) const { handshake(s, false); }
+    void server(boost::asio::ip::tcp::socket& s) const { handshake(s, true); }
+
+private:
+    std::shared_ptr<SSL_CTX> ctx_;
+
+    [[noreturn]] static void fail(const std::string& what){
+        char buf[256] = {0};
+        ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+        ERR_clear_error();
+        throw std::runtime_error("tls: " + what + ": " + buf);
+    }
+
+    void handshake(boost::asio::ip::tcp::socket& s, bool is_server) const {
+        if(!ctx_) return;
+        std::unique_ptr<SSL, decltype(&SSL_free)> ssl(SSL_new(ctx_.get()), SSL_free);
+        if(!ssl) fail("SSL_new");
+        // SSL_set_fd uses BIO_NOCLOSE: freeing the SSL leaves the socket open.
+        if(SSL_set_fd(ssl.get(), s.native_handle()) != 1) fail("SSL_set_fd");
+        if(is_server ? SSL_accept(ssl.get()) != 1 : SSL_connect(ssl.get()) != 1)
+            fail(is_server ? "handshake (accept)" : "handshake (connect)");
+        if(!BIO_get_ktls_send(SSL_get_wbio(ssl.get())) || !BIO_get_ktls_recv(SSL_get_rbio(ssl.get())))
+            throw std::runtime_error("tls: kernel offload unavailable (is the 'tls' module loaded?)");
+        // Keys now live in the kernel; drop the user-space state without a close_notify.
+    }
+};
@@ -0,0 +1,633 @@
+#pragma once
+// Dealer-free Du-Atallah triples (--pcg).
+//
+// The two parties generate their own correlations; the pairing server is not
+// contacted. Three layers, all semi-honest:
+//
+//  1. Base OT: 128 Chou-Orlandi OTs over P-256, once per session and direction.
+//  2. Silent correlated OT: IKNP extends the base OTs into one seed batch of
+//     COTs (K = M ^ r*delta, delta held by the COT sender). From then on every
+//     iteration turns the previous iteration's first k + t*h COTs into n fresh
+//     ones: t GGM trees give a regular-noise vector e (one punctured point per
+//     2^h leaves, h OTs per tree), and the primal-LPN map u = e + s*A with a
+//     public sparse A (LPN_D nonzeros per column) spreads it over n outputs.
+//     Per iteration the parties exchange ~0.6 MB for ~10.2 M new COTs.
+//  3. Gilboa multiplication: the receiver's 31 COT choice bits *are* its share
+//     a_i of one row, the sender's b_j enters through one correction word per
+//     bit (31 - bit bits wide, 62 B per row in total), and both end up with
+//     additive shares of a_i * b_j. A triple runs this in both directions:
+//         c = <a_A, b_A> + <a_B, b_B> + <a_A, b_B> + <a_B, b_A>
+//     where the first two terms are local.
+//
+// LPN parameters are the Ferret regular-noise set for 128-bit security
+// (Yang et al., CCS 2020). The COT layer is silent; layer 3 is not, so peer
+// traffic per triple is still linear in dim (about 124 bytes per row), but it
+// no longer passes through, or is known to, any third party.
+#include "common.hpp"
+#include <boost/asio.hpp>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Blocks are hashed and sent as their in-memory bytes.
+static_assert(std::endian::native == std::endian::little, "pcg.hpp assumes a little-endian host");
+
+struct Block {
+    uint64_t lo = 0, hi = 0;
+    Block& operator^=(const Block& o){ lo ^= o.lo; hi ^= o.hi; return *this; }
+    friend Block operator^(Block a, const Block& b){ return a ^= b; }
+    bool bit(unsigned j) const { return ((j < 64 ? lo >> j : hi >> (j - 64)) & 1u) != 0; }
+    void set_bit(unsigned j){ if(j < 64) lo |= uint64_t{1} << j; else hi |= uint64_t{1} << (j - 64); }
+};
+static_assert(sizeof(Block) == 16, "Block must be one AES block");
+
+struct LpnParams { std::size_t n, k, t, h; };
+constexpr LpnParams LPN = {10805248, 589760, 1319, 13}; // n = t << h
+constexpr int       LPN_D = 10;                         // nonzeros per column of A
+constexpr std::size_t LPN_RESERVE = LPN.k + LPN.t * LPN.h; // COTs one iteration consumes
+constexpr unsigned  RING_BITS = 31;                     // COTs per Gilboa product
+
+// ===== Socket helpers =====
+inline void pcg_send(boost::asio::ip::tcp::socket& s, const void* p, std::size_t n){ boost::asio::write(s, boost::asio::buffer(p, n)); }
+inline void pcg_recv(boost::asio::ip::tcp::socket& s, void* p, std::size_t n){ boost::asio::read(s, boost::asio::buffer(p, n)); }
+template <class T> inline void pcg_send_vec(boost::asio::ip::tcp::socket& s, const std::vector<T>& v){ pcg_send(s, v.data(), v.size() * sizeof(T)); }
+template <class T> inline std::vector<T> pcg_recv_vec(boost::asio::ip::tcp::socket& s, std::size_t n){
+    std::vector<T> v(n); pcg_recv(s, v.data(), n * sizeof(T)); return v;
+}
+
+// ===== AES building blocks =====
+// Fixed-key AES-128-ECB; distinct tags give independent permutations.
+class FixedKeyAes {
+public:
+    explicit FixedKeyAes(uint8_t tag) : ctx_(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free) {
+        uint8_t key[16] = {0x70, 0x63, 0x67, tag};
+        if(!ctx_ || EVP_EncryptInit_ex(ctx_.get(), EVP_aes_128_ecb(), nullptr, key, nullptr) != 1)
+            throw std::runtime_error("pcg: AES init failed");
+        EVP_CIPHER_CTX_set_padding(ctx_.get(), 0);
+    }
+    void encrypt(const Block* in, Block* out, std::size_t n){
+        constexpr std::size_t CHUNK = 1u << 22; // blocks; EVP lengths are int
+        for(std::size_t off = 0; off < n; off += CHUNK){
+            int len = static_cast<int>(std::min(CHUNK, n - off) * 16), outl = 0;
+            if(EVP_EncryptUpdate(ctx_.get(), reinterpret_cast<uint8_t*>(out + off), &outl,
+                                 reinterpret_cast<const uint8_t*>(in + off), len) != 1 || outl != len)
+                throw std::runtime_error("pcg: AES failed");
+        }
+    }
+    // Correlation-robust hash, in place: x := pi(x ^ tweak) ^ x ^ tweak.
+    void hash(Block* x, std::size_t n, const Block* tweak){
+        for(std::size_t i = 0; i < n; ++i) x[i] ^= tweak[i];
+        std::vector<Block> y(n);
+        encrypt(x, y.data(), n);
+        for(std::size_t i = 0; i < n; ++i) x[i] ^= y[i];
+    }
+
+private:
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx_;
+};
+
+// AES-128-CTR keystream under a block seed (iv = 0).
+class BlockPrg {
+public:
+    explicit BlockPrg(const Block& seed) : ctx_(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free) {
+        static const uint8_t iv[16] = {0};
+        if(!ctx_ || EVP_EncryptInit_ex(ctx_.get(), EVP_aes_128_ctr(), nullptr,
+                                       reinterpret_cast<const uint8_t*>(&seed), iv) != 1)
+            throw std::runtime_error("pcg: PRG init failed");
+    }
+    static BlockPrg fresh(){
+        Block seed;
+        if(RAND_bytes(reinterpret_cast<uint8_t*>(&seed), sizeof(seed)) != 1) throw std::runtime_error("pcg: RAND_bytes failed");
+        return BlockPrg(seed);
+    }
+    void fill(void* p, std::size_t bytes){
+        auto* b = static_cast<uint8_t*>(p);
+        std::memset(b, 0, bytes);
+        constexpr std::size_t CHUNK = 1u << 28;
+        for(std::size_t off = 0; off < bytes; off += CHUNK){
+            int len = static_cast<int>(std::min(CHUNK, bytes - off)), outl = 0;
+            if(EVP_EncryptUpdate(ctx_.get(), b + off, &outl, b + off, len) != 1 || outl != len)
+                throw std::runtime_error("pcg: PRG failed");
+        }
+    }
+    Block block(){ Block b; fill(&b, sizeof(b)); return b; }
+    std::vector<ringArithmetic> ring(std::size_t n){
+        std::vector<uint32_t> w(n);
+        fill(w.data(), n * 4);
+        std::vector<ringArithmetic> v(n);
+        for(std::size_t i = 0; i < n; ++i) v[i] = ringArithmetic(w[i]);
+        return v;
+    }
+
+private:
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx_;
+};
+
+// ===== Base OT (Chou-Orlandi, P-256) =====
+// Sender ends with (k0, k1) per OT, receiver with k_c for its choice bit c.
+class BaseOt {
+public:
+    static constexpr std::size_t COUNT = 128;
+    static constexpr std::size_t PT = 33; // compressed point
+
+    static std::vector<std::array<Block, 2>> send(boost::asio::ip::tcp::socket& s){
+        Ec ec;
+        auto a = ec.scalar();
+        auto A = ec.mul_gen(a.get());
+        const auto Aenc = ec.encode(A.get());
+        pcg_send(s, Aenc.data(), PT);
+
+        auto Benc = pcg_recv_vec<uint8_t>(s, COUNT * PT);
+        auto negA = ec.copy(A.get());
+        EC_POINT_invert(ec.g(), negA.get(), ec.bn());
+        std::vector<std::array<Block, 2>> out(COUNT);
+        for(std::size_t i = 0; i < COUNT; ++i){
+            auto B = ec.decode(Benc.data() + i * PT);
+            auto P0 = ec.mul(B.get(), a.get());
+            auto BmA = ec.point();
+            if(EC_POINT_add(ec.g(), BmA.get(), B.get(), negA.get(), ec.bn()) != 1) throw std::runtime_error("pcg: EC add");
+            auto P1 = ec.mul(BmA.get(), a.get());
+            out[i][0] = kdf(i, Aenc.data(), Benc.data() + i * PT, ec.encode(P0.get()).data());
+            out[i][1] = kdf(i, Aenc.data(), Benc.data() + i * PT, ec.encode(P1.get()).data());
+        }
+        return out;
+    }
+
+    static std::vector<Block> recv(boost::asio::ip::tcp::socket& s, const Block& choice){
+        Ec ec;
+        std::array<uint8_t, PT> Aenc;
+        pcg_recv(s, Aenc.data(), PT);
+        auto A = ec.decode(Aenc.data());
+
+        std::vector<uint8_t> Benc(COUNT * PT);
+        std::vector<Block> out(COUNT);
+        std::vector<Ec::Scalar> b;
+        for(std::size_t i = 0; i < COUNT; ++i){
+            b.push_back(ec.scalar());
+            auto B = ec.mul_gen(b.back().get());
+            if(choice.bit(static_cast<unsigned>(i)) &&
+               EC_POINT_add(ec.g(), B.get(), B.get(), A.get(), ec.bn()) != 1) throw std::runtime_error("pcg: EC add");
+            auto e = ec.encode(B.get());
+            std::memcpy(Benc.data() + i * PT, e.data(), PT);
+        }
+        pcg_send_vec(s, Benc);
+        for(std::size_t i = 0; i < COUNT; ++i){
+            auto P = ec.mul(A.get(), b[i].get());
+            out[i] = kdf(i, Aenc.data(), Benc.data() + i * PT, ec.encode(P.get()).data());
+        }
+        return out;
+    }
+
+private:
+    class Ec {
+    public:
+        using Point  = std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)>;
+        using Scalar = std::unique_ptr<BIGNUM, decltype(&BN_free)>;
+
+        Ec() : g_(EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1), EC_GROUP_free), bn_(BN_CTX_new(), BN_CTX_free) {
+            if(!g_ || !bn_) throw std::runtime_error("pcg: P-256 unavailable");
+        }
+        const EC_GROUP* g() const { return g_.get(); }
+        BN_CTX* bn() const { return bn_.get(); }
+
+        Point point() const {
+            Point p(EC_POINT_new(g_.get()), EC_POINT_free);
+            if(!p) throw std::runtime_error("pcg: EC_POINT_new");
+            return p;
+        }
+        Point copy(const EC_POINT* q) const {
+            Point p(EC_POINT_dup(q, g_.get()), EC_POINT_free);
+            if(!p) throw std::runtime_error("pcg: EC_POINT_dup");
+            return p;
+        }
+        Scalar scalar() const {
+            Scalar k(BN_new(), BN_free);
+            do{
+                if(!k || BN_rand_range(k.get(), EC_GROUP_get0_order(g_.get())) != 1) throw std::runtime_error("pcg: BN_rand_range");
+            } while(BN_is_zero(k.get()));
+            return k;
+        }
+        Point mul_gen(const BIGNUM* k) const {
+            auto p = point();
+            if(EC_POINT_mul(g_.get(), p.get(), k, nullptr, nullptr, bn_.get()) != 1) throw std::runtime_error("pcg: EC mul");
+            return p;
+        }
+        Point mul(const EC_POINT* q, const BIGNUM* k) const {
+            auto p = point();
+            if(EC_POINT_mul(g_.get(), p.get(), nullptr, q, k, bn_.get()) != 1) throw std::runtime_error("pcg: EC mul");
+            return p;
+        }
+        std::array<uint8_t, PT> encode(const EC_POINT* p) const {
+            std::array<uint8_t, PT> out{};
+            if(EC_POINT_point2oct(g_.get(), p, POINT_CONVERSION_COMPRESSED, out.data(), PT, bn_.get()) != PT)
+                throw std::runtime_error("pcg: EC encode");
+            return out;
+        }
+        Point decode(const uint8_t* in) const {
+            auto p = point();
+            if(EC_POINT_oct2point(g_.get(), p.get(), in, PT, bn_.get()) != 1 || EC_POINT_is_at_infinity(g_.get(), p.get()))
+                throw std::runtime_error("pcg: bad EC point from peer");
+            return p;
+        }
+
+    private:
+        std::unique_ptr<EC_GROUP, decltype(&EC_GROUP_free)> g_;
+        std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)> bn_;
+    };
+
+    // SHA-256(i || A || B || shared point), truncated to one block
+    static Block kdf(std::size_t i, const uint8_t* A, const uint8_t* B, const uint8_t* P){
+        uint8_t buf[8 + 3 * PT];
+        for(int j = 0; j < 8; ++j) buf[j] = static_cast<uint8_t>(static_cast<uint64_t>(i) >> (56 - 8*j));
+        std::memcpy(buf + 8, A, PT);
+        std::memcpy(buf + 8 + PT, B, PT);
+        std::memcpy(buf + 8 + 2*PT, P, PT);
+        uint8_t md[32]; unsigned mdlen = 0;
+        if(EVP_Digest(buf, sizeof(buf), md, &mdlen, EVP_sha256(), nullptr) != 1) throw std::runtime_error("pcg: SHA-256");
+        Block k; std::memcpy(&k, md, sizeof(k));
+        return k;
+    }
+};
+
+// ===== IKNP: base OTs -> m correlated OTs =====
+// Row j of a 128 x m bit matrix (m/8 bytes per row) -> m blocks, bit j of block i = bit i of row j.
+inline std::vector<Block> transpose_rows(const std::vector<std::vector<uint8_t>>& rows, std::size_t m){
+    std::vector<Block> out(m);
+    for(unsigned j = 0; j < 128; ++j){
+        const uint8_t* r = rows[j].data();
+        for(std::size_t byte = 0; byte < m / 8; ++byte){
+            uint8_t v = r[byte];
+            for(unsigned b = 0; v; ++b, v >>= 1)
+                if(v & 1u) out[byte * 8 + b].set_bit(j);
+        }
+    }
+    return out;
+}
+
+inline std::size_t round128(std::size_t m){ return (m + 127) / 128 * 128; }
+
+// ===== COT sender: holds delta, its K satisfy K = M ^ r*delta =====
+class CotSender {
+public:
+    // Base OTs (as their receiver, choosing by delta's bits) and IKNP for the first seed batch.
+    void setup(boost::asio::ip::tcp::socket& s){
+        auto prg = BlockPrg::fresh();
+        delta_ = prg.block();
+        auto keys = BaseOt::recv(s, delta_);
+        const std::size_t m = round128(LPN_RESERVE);
+        auto u = pcg_recv_vec<uint8_t>(s, 128 * (m / 8));
+        std::vector<std::vector<uint8_t>> q(128, std::vector<uint8_t>(m / 8));
+        for(unsigned j = 0; j < 128; ++j){
+            BlockPrg(keys[j]).fill(q[j].data(), m / 8);
+            if(delta_.bit(j)) for(std::size_t b = 0; b < m / 8; ++b) q[j][b] ^= u[j * (m / 8) + b];
+        }
+        reserve_ = transpose_rows(q, m);
+        reserve_.resize(LPN_RESERVE);
+        h0_.clear(); h1_.clear(); pos_ = 0; iter_ = 0;
+    }
+
+    std::size_t available() const { return h0_.size() - pos_; }
+
+    // One silent iteration: consumes the reserve, refills it and the pads.
+    void extend(boost::asio::ip::tcp::socket& s){
+        const std::size_t L = std::size_t{1} << LPN.h;
+        auto flips = pcg_recv_vec<uint8_t>(s, LPN.t * LPN.h);
+        auto prg = BlockPrg::fresh();
+        const Block lpn_seed = prg.block();
+
+        std::vector<Block> K(LPN.n);
+        std::vector<Block> msgs(LPN.t * (2 * LPN.h + 1));
+        FixedKeyAes left(1), right(2), crh(0);
+        std::vector<Block> cur(L), nxt(L), l(L / 2), r(L / 2);
+        for(std::size_t b = 0; b < LPN.t; ++b){
+            cur[0] = prg.block();
+            Block* m = msgs.data() + b * (2 * LPN.h + 1);
+            for(std::size_t lv = 0; lv < LPN.h; ++lv){
+                const std::size_t w = std::size_t{1} << lv;
+                ggm_expand(left, right, cur.data(), nxt.data(), w, l, r);
+                Block s0, s1;
+                for(std::size_t x = 0; x < w; ++x){ s0 ^= nxt[2*x]; s1 ^= nxt[2*x + 1]; }
+                std::swap(cur, nxt);
+                // OT of (s0, s1) keyed by reserve COT k + b*h + lv; the receiver's flip
+                // bit lines its choice up with the side it needs.
+                const std::size_t ci = LPN.k + b * LPN.h + lv;
+                Block k0 = reserve_[ci], k1 = reserve_[ci] ^ delta_;
+                if(flips[b * LPN.h + lv]) std::swap(k0, k1);
+                Block pads[2] = {k0, k1};
+                const Block tw[2] = {tweak(ci), tweak(ci)};
+                crh.hash(pads, 2, tw);
+                m[2*lv]     = s0 ^ pads[0];
+                m[2*lv + 1] = s1 ^ pads[1];
+            }
+            Block sum = delta_;
+            for(std::size_t x = 0; x < L; ++x){ sum ^= cur[x]; K[b * L + x] = cur[x]; }
+            m[2 * LPN.h] = sum;
+        }
+        pcg_send(s, &lpn_seed, sizeof(lpn_seed));
+        pcg_send_vec(s, msgs);
+
+        lpn_encode(lpn_seed, K.data(), nullptr, reserve_.data(), nullptr);
+        ++iter_;
+
+        // Reserve for the next iteration, pads H(K), H(K ^ delta) for the rest.
+        std::copy(K.begin(), K.begin() + LPN_RESERVE, reserve_.begin());
+        const std::size_t fresh = LPN.n - LPN_RESERVE;
+        std::vector<uint32_t> h0(fresh), h1(fresh);
+        FixedKeyAes pad(3);
+        constexpr std::size_t CH = 1u << 16;
+        std::vector<Block> x(CH), tw(CH);
+        for(std::size_t off = 0; off < fresh; off += CH){
+            const std::size_t cnt = std::min(CH, fresh - off);
+            for(std::size_t i = 0; i < cnt; ++i) tw[i] = tweak(LPN_RESERVE + off + i);
+            for(std::size_t i = 0; i < cnt; ++i) x[i] = K[LPN_RESERVE + off + i];
+            pad.hash(x.data(), cnt, tw.data());
+            for(std::size_t i = 0; i < cnt; ++i) h0[off + i] = static_cast<uint32_t>(x[i].lo);
+            for(std::size_t i = 0; i < cnt; ++i) x[i] = K[LPN_RESERVE + off + i] ^ delta_;
+            pad.hash(x.data(), cnt, tw.data());
+            for(std::size_t i = 0; i < cnt; ++i) h1[off + i] = static_cast<uint32_t>(x[i].lo);
+        }
+        h0_.erase(h0_.begin(), h0_.begin() + static_cast<std::ptrdiff_t>(pos_));
+        h1_.erase(h1_.begin(), h1_.begin() + static_cast<std::ptrdiff_t>(pos_));
+        pos_ = 0;
+        h0_.insert(h0_.end(), h0.begin(), h0.end());
+        h1_.insert(h1_.end(), h1.begin(), h1.end());
+    }
+
+    // Gilboa, sender side, for rows of y with enough pads available:
+    // per row it keeps -sum_j 2^j h0 and sends (y + h0 - h1) mod 2^(31-j) per bit j.
+    std::vector<ringArithmetic> multiply(boost::asio::ip::tcp::socket& s, const ringArithmetic* y, std::size_t rows){
+        std::vector<ringArithmetic> share(rows);
+        std::vector<uint8_t> out;
+        out.reserve(rows * 62 + 8);
+        uint64_t acc = 0; unsigned nb = 0;
+        for(std::size_t i = 0; i < rows; ++i){
+            uint32_t sh = 0;
+            for(unsigned j = 0; j < RING_BITS; ++j){
+                const uint32_t a0 = h0_[pos_], a1 = h1_[pos_]; ++pos_;
+                const unsigned w = RING_BITS - j;
+                sh -= a0 << j;
+                acc |= static_cast<uint64_t>((y[i].value + a0 - a1) & ((1u << w) - 1)) << nb;
+                nb += w;
+                while(nb >= 8){ out.push_back(static_cast<uint8_t>(acc)); acc >>= 8; nb -= 8; }
+            }
+            share[i] = ringArithmetic(sh);
+        }
+        if(nb) out.push_back(static_cast<uint8_t>(acc));
+        pcg_send_vec(s, out);
+        return share;
+    }
+
+private:
+    Block delta_;
+    std::vector<Block> reserve_;
+    std::vector<uint32_t> h0_, h1_;
+    std::size_t pos_ = 0;
+    uint64_t iter_ = 0;
+
+    Block tweak(std::size_t i) const { return Block{static_cast<uint64_t>(i), iter_}; }
+
+    friend class CotReceiver;
+    static void ggm_expand(FixedKeyAes& left, FixedKeyAes& right, const Block* in, Block* out, std::size_t w,
+                           std::vector<Block>& l, std::vector<Block>& r){
+        left.encrypt(in, l.data(), w);
+        right.encrypt(in, r.data(), w);
+        for(std::size_t x = 0; x < w; ++x){ out[2*x] = l[x] ^ in[x]; out[2*x + 1] = r[x] ^ in[x]; }
+    }
+
+public:
+    // u = e + s*A (bits) and M/K = M_e/K_e + M_s/K_s * A, in place over the n outputs.
+    // Both parties derive the same sparse A from the sender's public seed.
+    static void lpn_encode(const Block& seed, Block* v, uint8_t* bits, const Block* res, const uint8_t* res_bits){
+        BlockPrg prg(seed);
+        constexpr std::size_t CH = 1u << 16;
+        std::vector<uint32_t> idx(CH * LPN_D);
+        for(std::size_t off = 0; off < LPN.n; off += CH){
+            const std::size_t cnt = std::min(CH, LPN.n - off);
+            prg.fill(idx.data(), cnt * LPN_D * 4);
+            for(std::size_t i = 0; i < cnt; ++i){
+                Block acc = v[off + i];
+                uint8_t b = bits ? bits[off + i] : 0;
+                for(int d = 0; d < LPN_D; ++d){
+                    const uint32_t j = idx[i * LPN_D + d] % static_cast<uint32_t>(LPN.k);
+                    acc ^= res[j];
+                    if(bits) b ^= res_bits[j];
+                }
+                v[off + i] = acc;
+                if(bits) bits[off + i] = b;
+            }
+        }
+    }
+};
+
+// ===== COT receiver: holds choice bits r and M =====
+class CotReceiver {
+public:
+    // Base OTs (as their sender) and IKNP for the first seed batch, with random choice bits.
+    void setup(boost::asio::ip::tcp::socket& s){
+        auto keys = BaseOt::send(s);
+        const std::size_t m = round128(LPN_RESERVE);
+        auto prg = BlockPrg::fresh();
+        std::vector<uint8_t> rpack(m / 8);
+        prg.fill(rpack.data(), rpack.size());
+        std::vector<std::vector<uint8_t>> t(128, std::vector<uint8_t>(m / 8));
+        std::vector<uint8_t> u(128 * (m / 8)), g(m / 8);
+        for(unsigned j = 0; j < 128; ++j){
+            BlockPrg(keys[j][0]).fill(t[j].data(), m / 8);
+            BlockPrg(keys[j][1]).fill(g.data(), m / 8);
+            for(std::size_t b = 0; b < m / 8; ++b) u[j * (m / 8) + b] = t[j][b] ^ g[b] ^ rpack[b];
+        }
+        pcg_send_vec(s, u);
+        reserve_ = transpose_rows(t, m);
+        reserve_.resize(LPN_RESERVE);
+        rbits_.resize(LPN_RESERVE);
+        for(std::size_t i = 0; i < LPN_RESERVE; ++i) rbits_[i] = (rpack[i / 8] >> (i % 8)) & 1u;
+        r_.clear(); hm_.clear(); pos_ = 0; iter_ = 0;
+    }
+
+    std::size_t available() const { return hm_.size() - pos_; }
+
+    void extend(boost::asio::ip::tcp::socket& s){
+        const std::size_t L = std::size_t{1} << LPN.h;
+        auto prg = BlockPrg::fresh();
+        std::vector<uint32_t> alpha(LPN.t);
+        prg.fill(alpha.data(), alpha.size() * 4);
+        for(auto& a : alpha) a &= static_cast<uint32_t>(L - 1);
+
+        // Level lv of tree b: the path goes to child bit p; we need the other side's sum.
+        std::vector<uint8_t> flips(LPN.t * LPN.h);
+        for(std::size_t b = 0; b < LPN.t; ++b)
+            for(std::size_t lv = 0; lv < LPN.h; ++lv){
+                const unsigned p = (alpha[b] >> (LPN.h - 1 - lv)) & 1u;
+                flips[b * LPN.h + lv] = static_cast<uint8_t>(rbits_[LPN.k + b * LPN.h + lv] ^ (1u - p));
+            }
+        pcg_send_vec(s, flips);
+        Block lpn_seed;
+        pcg_recv(s, &lpn_seed, sizeof(lpn_seed));
+        auto msgs = pcg_recv_vec<Block>(s, LPN.t * (2 * LPN.h + 1));
+
+        std::vector<Block> M(LPN.n);
+        std::vector<uint8_t> u(LPN.n, 0);
+        FixedKeyAes left(1), right(2), crh(0);
+        std::vector<Block> cur(L), nxt(L), l(L / 2), r(L / 2);
+        for(std::size_t b = 0; b < LPN.t; ++b){
+            const Block* m = msgs.data() + b * (2 * LPN.h + 1);
+            std::size_t path = 0;
+            cur[0] = Block{};
+            for(std::size_t lv = 0; lv < LPN.h; ++lv){
+                const std::size_t w = std::size_t{1} << lv;
+                CotSender::ggm_expand(left, right, cur.data(), nxt.data(), w, l, r);
+                const unsigned p = (alpha[b] >> (LPN.h - 1 - lv)) & 1u, side = 1u - p;
+                const std::size_t ci = LPN.k + b * LPN.h + lv;
+                Block pad = reserve_[ci];
+                const Block tw = tweak(ci);
+                crh.hash(&pad, 1, &tw);
+                Block sum = m[2*lv + side] ^ pad;          // xor of all side-nodes at this level
+                const std::size_t target = 2*path + side;
+                for(std::size_t x = 0; x < w; ++x) if(2*x + side != target) sum ^= nxt[2*x + side];
+                nxt[target] = sum;
+                nxt[2*path + p] = Block{};
+                path = 2*path + p;
+                std::swap(cur, nxt);
+            }
+            Block leaf = m[2 * LPN.h];                      // delta ^ xor of all leaves
+            for(std::size_t x = 0; x < L; ++x) if(x != path) leaf ^= cur[x];
+            cur[path] = leaf;                               // = v_alpha ^ delta
+            std::copy(cur.begin(), cur.end(), M.begin() + static_cast<std::ptrdiff_t>(b * L));
+            u[b * L + path] = 1;
+        }
+
+        CotSender::lpn_encode(lpn_seed, M.data(), u.data(), reserve_.data(), rbits_.data());
+        ++iter_;
+
+        std::copy(M.begin(), M.begin() + LPN_RESERVE, reserve_.begin());
+        std::copy(u.begin(), u.begin() + LPN_RESERVE, rbits_.begin());
+        const std::size_t fresh = LPN.n - LPN_RESERVE;
+        std::vector<uint32_t> hm(fresh);
+        FixedKeyAes pad(3);
+        constexpr std::size_t CH = 1u << 16;
+        std::vector<Block> x(CH), tw(CH);
+        for(std::size_t off = 0; off < fresh; off += CH){
+            const std::size_t cnt = std::min(CH, fresh - off);
+            for(std::size_t i = 0; i < cnt; ++i){ tw[i] = tweak(LPN_RESERVE + off + i); x[i] = M[LPN_RESERVE + off + i]; }
+            pad.hash(x.data(), cnt, tw.data());
+            for(std::size_t i = 0; i < cnt; ++i) hm[off + i] = static_cast<uint32_t>(x[i].lo);
+        }
+        r_.erase(r_.begin(), r_.begin() + static_cast<std::ptrdiff_t>(pos_));
+        hm_.erase(hm_.begin(), hm_.begin() + static_cast<std::ptrdiff_t>(pos_));
+        pos_ = 0;
+        r_.insert(r_.end(), u.begin() + static_cast<std::ptrdiff_t>(LPN_RESERVE), u.end());
+        hm_.insert(hm_.end(), hm.begin(), hm.end());
+    }
+
+    // Gilboa, receiver side: row i's value a_i is its 31 choice bits; its share of
+    // a_i * y_i is sum_j 2^j (H(M) + r_j * tau_j).
+    std::vector<ringArithmetic> multiply(boost::asio::ip::tcp::socket& s, ringArithmetic* a, std::size_t rows){
+        auto in = pcg_recv_vec<uint8_t>(s, (rows * (RING_BITS * (RING_BITS + 1) / 2) + 7) / 8);
+        std::vector<ringArithmetic> share(rows);
+        std::size_t at = 0;
+        uint64_t acc = 0; unsigned nb = 0;
+        for(std::size_t i = 0; i < rows; ++i){
+            uint32_t av = 0, sh = 0;
+            for(unsigned j = 0; j < RING_BITS; ++j){
+                const unsigned w = RING_BITS - j;
+                while(nb < w){ acc |= static_cast<uint64_t>(in[at++]) << nb; nb += 8; }
+                const uint32_t tau = static_cast<uint32_t>(acc) & ((1u << w) - 1);
+                acc >>= w; nb -= w;
+                const uint32_t bit = r_[pos_], h = hm_[pos_]; ++pos_;
+                av |= bit << j;
+                sh += (h + (bit ? tau : 0u)) << j;
+            }
+            a[i] = ringArithmetic(av);
+            share[i] = ringArithmetic(sh);
+        }
+        return share;
+    }
+
+private:
+    std::vector<Block> reserve_;
+    std::vector<uint8_t> rbits_;
+    std::vector<uint8_t> r_;
+    std::vector<uint32_t> hm_;
+    std::size_t pos_ = 0;
+    uint64_t iter_ = 0;
+
+    Block tweak(std::size_t i) const { return Block{static_cast<uint64_t>(i), iter_}; }
+};
+
+// ===== One party's end of the generator =====
+// Party A is the COT receiver for the A<-B direction and the sender for
+// A->B; B the opposite. Directions always run A<-B first, so both parties
+// walk through the same message sequence on the one socket.
+struct PcgTriple {
+    std::vector<ringArithmetic> a, b, c; // c: 1 word (dot) or dim words (element-wise)
+};
+
+class PcgParty {
+public:
+    explicit PcgParty(bool is_a) : is_a_(is_a) {}
+
+    void setup(boost::asio::ip::tcp::socket& s){
+        if(is_a_){ recv_.setup(s); send_.setup(s); }
+        else     { send_.setup(s); recv_.setup(s); }
+    }
+
+    PcgTriple triple(boost::asio::ip::tcp::socket& s, std::size_t dim, bool elementwise){
+        PcgTriple t;
+        t.b = BlockPrg::fresh().ring(dim);
+        t.a.resize(dim);
+        std::vector<ringArithmetic> x_recv, x_send;
+        if(is_a_){ x_recv = as_receiver(s, t.a); x_send = as_sender(s, t.b); }
+        else     { x_send = as_sender(s, t.b); x_recv = as_receiver(s, t.a); }
+
+        if(elementwise){
+            t.c.resize(dim);
+            for(std::size_t i = 0; i < dim; ++i) t.c[i] = t.a[i] * t.b[i] + x_recv[i] + x_send[i];
+        }else{
+            ringArithmetic c(0);
+            for(std::size_t i = 0; i < dim; ++i) c += t.a[i] * t.b[i] + x_recv[i] + x_send[i];
+            t.c.assign(1, c);
+        }
+        return t;
+    }
+
+private:
+    bool is_a_;
+    CotSender send_;
+    CotReceiver recv_;
+
+    // Rows are multiplied in chunks of whatever the pads cover; both parties
+    // see the same pad counts, so they extend at the same points.
+    std::vector<ringArithmetic> as_sender(boost::asio::ip::tcp::socket& s, const std::vector<ringArithmetic>& y){
+        std::vector<ringArithmetic> out; out.reserve(y.size());
+        for(std::size_t i = 0; i < y.size(); ){
+            if(send_.available() < RING_BITS) send_.extend(s);
+            const std::size_t rows = std::min(y.size() - i, send_.available() / RING_BITS);
+            auto part = send_.multiply(s, y.data() + i, rows);
+            out.insert(out.end(), part.begin(), part.end());
+            i += rows;
+        }
+        return out;
+    }
+    std::vector<ringArithmetic> as_receiver(boost::asio::ip::tcp::socket& s, std::vector<ringArithmetic>& a){
+        std::vector<ringArithmetic> out; out.reserve(a.size());
+        for(std::size_t i = 0; i < a.size(); ){
+            if(recv_.available() < RING_BITS) recv_.extend(s);
+            const std::size_t rows = std::min(a.size() - i, recv_.available() / RING_BITS);
+            auto part = recv_.multiply(s, a.data() + i, rows);
+            out.insert(out.end(), part.begin(), part.end());
+            i += rows;
+        }
+        return out;
+    }
+};
@@ -14,6 +14,13 @@ B_PEER_TARGET="127.0.0.1:9701"  # B will send residuals to A’s peer-listen
 
 ROWS="${ROWS:-1024}"            # DUORAM rows (can override: ROWS=2048 ./run_tmux.sh)
 
+# Optional kTLS on every link: TLS_DIR must hold node.pem, node.key and ca.pem
+# (needs the kernel 'tls' module: sudo modprobe tls)
+TLS_ARGS=""
+if [[ -n "${TLS_DIR:-}" ]]; then
+  TLS_ARGS="--tls-cert ${TLS_DIR}/node.pem --tls-key ${TLS_DIR}/node.key --tls-ca ${TLS_DIR}/ca.pem"
+fi
+
 SERVER_BIN="./share_server"
 CLIENT_BIN="./party_client"
 COORD_BIN="./coordinator_cli"
@@ -30,7 +37,7 @@ tmux has-session -t "${SESSION}" 2>/dev/null && tmux kill-session -t "${SESSION}
 # Create a new session, window 0, pane 0: Share Server
 tmux new-session -d -s "${SESSION}" -n "server"
 tmux send-keys -t "${SESSION}":0.0 "echo 'Starting Share Server on ${SERVER_ADDR}'" C-m
-tmux send-keys -t "${SESSION}":0.0 "${SERVER_BIN} --listen ${SERVER_ADDR}" C-m
+tmux send-keys -t "${SESSION}":0.0 "${SERVER_BIN} --listen ${SERVER_ADDR} ${TLS_ARGS}" C-m
 
 # Split window 0 vertically for Party A
 tmux split-window -v -t "${SESSION}":0
@@ -40,7 +47,7 @@ tmux send-keys -t "${SESSION}":0.1 \
     --listen ${A_LISTEN} \
     --peer-listen ${A_PEER_LISTEN} \
     --peer ${A_PEER_TARGET} \
-    --share ${SERVER_ADDR}" C-m
+    --share ${SERVER_ADDR} ${TLS_ARGS}" C-m
 
 # Split window 0 again (horizontal split on bottom pane) for Party B
 tmux split-window -h -t "${SESSION}":0.1
@@ -50,15 +57,15 @@ tmux send-keys -t "${SESSION}":0.2 \
     --listen ${B_LISTEN} \
     --peer-listen ${B_PEER_LISTEN} \
     --peer ${B_PEER_TARGET} \
-    --share ${SERVER_ADDR}" C-m
+    --share ${SERVER_ADDR} ${TLS_ARGS}" C-m
 
 # Optional: create a second tmux window for the Coordinator CLI
 tmux new-window -t "${SESSION}" -n "coord"
 tmux send-keys -t "${SESSION}":1.0 "echo 'Coordinator window. Examples:'" C-m
 tmux send-keys -t "${SESSION}":1.0 \
-  "echo './coordinator_cli --op write --dim ${ROWS} --idx 7 --val 12345 --c0 ${A_LISTEN} --c1 ${B_LISTEN}'" C-m
+  "echo './coordinator_cli --op write --dim ${ROWS} --idx 7 --val 12345 --c0 ${A_LISTEN} --c1 ${B_LISTEN} ${TLS_ARGS}'" C-m
 tmux send-keys -t "${SESSION}":1.0 \
-  "echo './coordinator_cli --op read  --dim ${ROWS} --idx 7 --c0 ${A_LISTEN} --c1 ${B_LISTEN}'" C-m
+  "echo './coordinator_cli --op read  --dim ${ROWS} --idx 7 --c0 ${A_LISTEN} --c1 ${B_LISTEN} ${TLS_ARGS}'" C-m
 
 # Attach to the tmux session
 tmux select-window -t "${SESSION}":0
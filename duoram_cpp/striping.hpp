@@ -0,0 +1,73 @@
+#pragma once
+// Striping of large frames across parallel TCP connections.
+//
+// A frame of `words` 32-bit words is cut into n contiguous stripes; each
+// stripe travels on its own connection tagged with (offset, count) and the
+// receiver reassembles by offset. A single long-haul TCP stream is capped at
+// cwnd/RTT, so n streams lift that ceiling roughly n-fold on WAN links.
+// Both ends derive the stripe layout from plan_stripes(), so it must stay
+// deterministic.
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Stripe { uint32_t off = 0, cnt = 0; };
+
+constexpr uint32_t    STRIPE_AUTO       = 0;          // --streams auto
+constexpr uint32_t    STRIPE_MAX        = 16;         // fits the u8 on the wire with room to spare
+constexpr std::size_t STRIPE_AUTO_BYTES = 8u << 20;   // auto: one stream per 8 MB of frame
+constexpr std::size_t STRIPE_MIN_BYTES  = 1u << 20;   // fixed N: no stripe smaller than 1 MB
+
+// "auto" or 1..STRIPE_MAX
+inline uint32_t parse_streams(const std::string& s){
+    if(s == "auto") return STRIPE_AUTO;
+    unsigned long n = std::stoul(s);
+    if(n < 1 || n > STRIPE_MAX) throw std::runtime_error("--streams must be auto or 1.." + std::to_string(STRIPE_MAX));
+    return static_cast<uint32_t>(n);
+}
+
+// Number of stripes for a frame. Each extra stripe costs a TCP (and TLS)
+// handshake, so small frames (sync digests, dot-triple frames of small tables)
+// always travel on one connection, whatever --streams says.
+inline uint32_t stripe_count(std::size_t words, uint32_t streams){
+    std::size_t n = streams;
+    if(streams == STRIPE_AUTO){
+        n = (words * 4 + STRIPE_AUTO_BYTES - 1) / STRIPE_AUTO_BYTES;
+        if(n > STRIPE_MAX) n = STRIPE_MAX;
+    }
+    const std::size_t by_size = words * 4 / STRIPE_MIN_BYTES;
+    if(n > by_size) n = by_size;
+    return n == 0 ? 1u : static_cast<uint32_t>(n);
+}
+
+// Even split; the first (words % n) stripes carry one extra word.
+inline std::vector<Stripe> plan_stripes(uint32_t words, uint32_t n){
+    if(n == 0) throw std::runtime_error("plan_stripes: n must be > 0");
+    std::vector<Stripe> st(n);
+    uint32_t base = words / n, extra = words % n, off = 0;
+    for(uint32_t k=0;k<n;++k){
+        st[k].off = off;
+        st[k].cnt = base + (k < extra ? 1u : 0u);
+        off += st[k].cnt;
+    }
+    return st;
+}
+
+// Run fn(k, stripe) for every stripe, stripe 0 on the calling thread and the
+// rest concurrently. Rethrows the first failure after all stripes finished.
+template <class F>
+inline void for_each_stripe(const std::vector<Stripe>& stripes, F&& fn){
+    std::vector<std::future<void>> rest;
+    for(std::size_t k=1;k<stripes.size();++k)
+        rest.push_back(std::async(std::launch::async, [&fn, &stripes, k]{ fn(k, stripes[k]); }));
+    std::exception_ptr err;
+    try{ if(!stripes.empty()) fn(std::size_t{0}, stripes[0]); } catch(...){ err = std::current_exception(); }
+    for(auto& f: rest){
+        try{ f.get(); } catch(...){ if(!err) err = std::current_exception(); }
+    }
+    if(err) std::rethrow_exception(err);
+}